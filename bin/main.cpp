@@ -6,18 +6,19 @@
 #include "lib/arg_parser.h"
 
 struct Options {
+    std::vector<int> values;
     bool sum = false;
     bool mult = false;
 };
 
 int main(int argc, char** argv) {
     Options opt;
-    std::vector<int> values;
 
     ArgumentParser::ArgParser parser("Program");
-    parser.AddIntArgument("--N").MultiValue(1).Positional().StoreValues(values);
-    parser.AddFlag("-s", "--sum", "add args").StoreValue(opt.sum);
-    parser.AddFlag("-m", "--mult", "multiply args").StoreValue(opt.mult);
+    parser.Bind(opt);
+    parser.AddIntArgument("--N").MultiValue(1).Positional().Field(&Options::values);
+    parser.AddFlag("-s", "--sum", "add args").Field(&Options::sum);
+    parser.AddFlag("-m", "--mult", "multiply args").Field(&Options::mult);
     parser.AddHelp("Program accumulate arguments");
     
     if (!parser.Parse(argc, argv)) {
@@ -31,9 +32,9 @@ int main(int argc, char** argv) {
     }
 
     if (opt.sum) {
-        std::cout << "Result: " << std::accumulate(values.begin(), values.end(), 0) << std::endl;
+        std::cout << "Result: " << std::accumulate(opt.values.begin(), opt.values.end(), 0) << std::endl;
     } else if (opt.mult) {
-        std::cout << "Result: " << std::accumulate(values.begin(), values.end(), 1, std::multiplies<>()) <<
+        std::cout << "Result: " << std::accumulate(opt.values.begin(), opt.values.end(), 1, std::multiplies<>()) <<
             std::endl;
     } else {
         std::cout << "No one options had chosen" << std::endl;
@@ -1,9 +1,19 @@
 #include <sstream>
 #include <charconv>
+#include <cstring>
+#include <limits>
 #include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <utility>
 
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
 #include "arg_parser.h"
+#include "glob.h"
+#include "utf8.h"
 
 namespace {
 void PrintError(const std::string_view msg, const std::string_view spec) {
@@ -14,8 +24,55 @@ void PrintWarning(const std::string_view msg, const std::string_view spec = "")
     std::cerr << "Warning: " << msg << ' ' << spec << '\n';
 }
 
-std::string MergeChars(const char a, const char b) {
-    return std::string() + a + b;
+void PrintInvalidValue(const std::string_view arg, const std::string_view value) {
+    std::cerr << "Warning: Invalid value for argument " << arg << ": " << value << '\n';
+}
+
+void PrintTooManyValues(const std::string_view arg, const std::string_view value) {
+    std::cerr << "Warning: Too many values for argument " << arg << ": " << value << '\n';
+}
+
+// Shorter command lines are not worth waking up the thread pool
+constexpr size_t kMinParallelTokens = 4096;
+constexpr size_t kParallelGrain = 1024;
+constexpr size_t kBatchGrain = 64;
+// stat, access and directory reads mostly wait for the disk, a few threads are enough to overlap them
+constexpr size_t kIoThreads = 4;
+
+ArgumentParser::PathError CheckFileSystem(const std::string& path, const uint8_t checks) {
+    using ArgumentParser::PathCheck;
+    using ArgumentParser::PathError;
+
+    std::error_code error;
+    const auto status = std::filesystem::status(path, error);
+    if (!std::filesystem::exists(status))
+        return PathError::kMissing;
+    if ((checks & PathCheck::kIsDirectory) && !std::filesystem::is_directory(status))
+        return PathError::kNotDirectory;
+#ifdef __unix__
+    if ((checks & PathCheck::kReadable) && access(path.c_str(), R_OK) != 0)
+        return PathError::kNotReadable;
+#endif
+
+    return PathError::kNone;
+}
+
+void PrintPathError(const ArgumentParser::PathCheck& check) {
+    using ArgumentParser::PathError;
+
+    switch (check.error) {
+        case PathError::kMissing:
+            std::cerr << "Warning: No such path for argument " << check.argument << ": " << check.path << '\n';
+            break;
+        case PathError::kNotDirectory:
+            std::cerr << "Warning: Not a directory for argument " << check.argument << ": " << check.path << '\n';
+            break;
+        case PathError::kNotReadable:
+            std::cerr << "Warning: Path is not readable for argument " << check.argument << ": " << check.path << '\n';
+            break;
+        default:
+            break;
+    }
 }
 }
 
@@ -23,115 +80,971 @@ namespace ArgumentParser {
 ArgParser::ArgParser(std::string name) : program_name_(std::move(name)) {
 }
 
-bool IsFlagArgument(const FlagConfig& args, const std::string& arg) {
-    return args.Contains(arg) || args.KeyContains(arg);
+ArgParser::ArgParser(const ArgParser& other)
+    : program_name_(other.program_name_),
+      cur_type_(other.cur_type_),
+      cur_id_(other.cur_id_),
+      is_pass_through_(other.is_pass_through_),
+      is_coincidence_(other.is_coincidence_),
+      strings_(other.strings_),
+      flags_(other.flags_),
+      int_args_(other.int_args_),
+      str_args_(other.str_args_),
+      enum_args_(other.enum_args_),
+      arguments_(other.arguments_),
+      required_(other.required_),
+      seen_(other.seen_),
+      exclusive_groups_(other.exclusive_groups_),
+      requirements_(other.requirements_),
+      env_index_(other.env_index_),
+      env_bindings_(other.env_bindings_),
+      env_prefix_(other.env_prefix_) {
+}
+
+void ArgParser::ResetValues() {
+    is_added_help_ = false;
+    flags_.ResetValues();
+    int_args_.ResetValues();
+    str_args_.ResetValues();
+    enum_args_.ResetValues();
 }
 
-bool IsIntArgument(const IntArgumentConfig& args, const std::string& arg) {
-    return args.Contains(arg) || args.KeyContains(arg);
+bool ArgParser::Parse(const std::vector<std::string>& args) {
+    return ParseTokens(args);
 }
 
-bool IsStringArgument(const StringArgumentConfig& args, const std::string& arg) {
-    return args.Contains(arg) || args.KeyContains(arg);
+bool ArgParser::ParseCommandLine(const std::string_view command) {
+    ShellLexer lexer;
+    std::vector<std::string_view> tokens;
+    if (!lexer.Split(command, tokens)) {
+        PrintWarning("Unterminated quote in command:", command);
+        return false;
+    }
+
+    return ParseTokens(tokens);
 }
 
-bool ArgParser::Parse(const std::vector<std::string>& args) {
+bool ArgParser::ParseTokens(const TokenRange args) {
     if (IsArgumentCoincidence())
         return false;
 
-    for (auto& elem: args) {
-        if (elem == "--help" || elem == "-h") {
+    // Without a consumer of the events nothing is kept, and no coroutine frame is allocated
+    auto ignore = [](const ParseEvent&) {};
+    return ParseLine(args, ignore);
+}
+
+Generator<ParseEvent> ArgParser::Events(const std::span<const std::string_view> args) {
+    return ParseEvents(args);
+}
+
+Generator<ParseEvent> ArgParser::Events(const std::vector<std::string>& args) {
+    return ParseEvents(args);
+}
+
+Generator<ParseEvent> ArgParser::Events(int argc, char** argv) {
+    return ParseEvents(TokenRange(argc, argv));
+}
+
+Generator<ParseEvent> ArgParser::ParseEvents(const TokenRange args) {
+    if (IsArgumentCoincidence()) {
+        co_yield ParseEvent{ParseEventKind::kError, {}, {}, 0};
+        co_return;
+    }
+
+    BeginParse();
+    const PathCheckWait wait{*this};
+
+    size_t separator = args.Size();
+    if (const size_t help = FindHelp(args, separator) ; help != kNoArgument) {
+        co_yield ParseEvent{ParseEventKind::kHelp, args[help], {}, help};
+        co_return;
+    }
+
+    ClassifiedTokens classified;
+    ClassifyTokens(args, classified);
+
+    auto emit = [this](const ParseEvent& event) {
+        token_events_.push_back(event);
+    };
+
+    for (size_t i = 1 ; i < separator ; ++i) {
+        // A token gives a few events, a bundle one per flag, the buffer is the parser's and keeps its capacity
+        token_events_.clear();
+        const bool is_parsed = ParseStep(args, i, separator, classified, emit);
+        for (const auto& event: token_events_) {
+            co_yield event;
+        }
+        if (!is_parsed)
+            co_return;
+    }
+
+    for (size_t i = separator + 1 ; i < args.Size() ; ++i) {
+        co_yield ParseEvent{ParseEventKind::kPassThrough, {}, args[i], i};
+    }
+
+    if (ParseEvent error{} ; !FinishParse(args.Size(), error))
+        co_yield error;
+}
+
+size_t ArgParser::FindHelp(const TokenRange args, size_t& separator) {
+    // Tokens from the separator on belong to the program the arguments are passed to
+    separator = args.Size();
+    for (size_t i = 0 ; i < args.Size() ; ++i) {
+        if (is_pass_through_ && i > 0 && args[i] == "--") {
+            separator = i;
+            break;
+        }
+        if (args[i] == "--help" || args[i] == "-h") {
             is_added_help_ = true;
-            return true;
+            ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(i), TraceDecision::kHelp, args[i]}));
+            return i;
         }
     }
 
-    for (size_t i = 1 ; i < args.size() ; ++i) {
-        {
-            std::vector<std::string> cur_arg_config;
-            cur_arg_config.push_back(args[i]);
-            if (i + 1 < args.size())
-                cur_arg_config.push_back(args[i + 1]);
+    return kNoArgument;
+}
 
-            size_t j = 0;
-            const auto is_argument = this->IsArgument(cur_arg_config, j);
+template<class Emit>
+bool ArgParser::ParseLine(const TokenRange args, Emit& emit) {
+    BeginParse();
+    const PathCheckWait wait{*this};
 
-            i += j;
+    size_t separator = args.Size();
+    if (const size_t help = FindHelp(args, separator) ; help != kNoArgument) {
+        emit({ParseEventKind::kHelp, args[help], {}, help});
+        return true;
+    }
 
-            if (is_argument == ArgumentCheckStatus::kParsingFailure)
-                return false;
+    ClassifiedTokens classified;
+    ClassifyTokens(args, classified);
 
-            if (is_argument == ArgumentCheckStatus::kCorrectArgument)
-                continue;
-        }
+    for (size_t i = 1 ; i < separator ; ++i) {
+        if (!ParseStep(args, i, separator, classified, emit))
+            return false;
+    }
 
-        //ArgumentCheckStatus::kIncorrectArgument
-        if (int result = 0 ; std::from_chars(args[i].data(), args[i].data() + args[i].size(), result).ec ==
-            std::errc{}
-            && int_args_
-            .IsPositional()) {
-            int_args_.SetParcedArgument(int_args_.GetPositional(), result);
-        } else if (str_args_.IsPositional()) {
-            str_args_.SetParcedArgument(str_args_.GetPositional(), args[i]);
+    for (size_t i = separator + 1 ; i < args.Size() ; ++i)
+        emit({ParseEventKind::kPassThrough, {}, args[i], i});
+
+    if (ParseEvent error{} ; !FinishParse(args.Size(), error)) {
+        emit(error);
+        return false;
+    }
+
+    return true;
+}
+
+template<class Emit>
+bool ArgParser::ParseStep(const TokenRange args, size_t& i, const size_t separator,
+                          ClassifiedTokens& classified, Emit& emit) {
+    remaining_tokens_ = separator - i;
+
+    // kInvalidPositional tokens fall through to the sequential checks, so the first bad value by position is reported
+    if (!classified.kinds.empty() && (classified.kinds[i] == TokenKind::kIntPositional
+                                      || classified.kinds[i] == TokenKind::kStringPositional)) {
+        const auto& kinds = classified.kinds;
+        size_t end = i;
+        while (end < separator && kinds[end] == kinds[i])
+            ++end;
+
+        size_t count = end - i;
+        const bool is_int = kinds[i] == TokenKind::kIntPositional;
+        std::string_view arg;
+        if (is_int) {
+            const size_t id = int_args_.GetPositional();
+            arg = int_args_.GetName(strings_, id);
+            count = std::min(count, int_args_.GetValuesLeft(id));
+            seen_.Set(int_args_.GetBit(id));
+            int_args_.ReserveValues(id, remaining_tokens_);
+            int_args_.SetParcedArguments(id, std::span(classified.int_values).subspan(i, count));
         } else {
-            bool is_any_wrong_key = false;
+            const size_t id = str_args_.GetPositional();
+            arg = str_args_.GetName(strings_, id);
+            count = std::min(count, str_args_.GetValuesLeft(id));
+            seen_.Set(str_args_.GetBit(id));
+            str_args_.ReserveValues(id, remaining_tokens_);
+            str_args_.SetParcedArguments(id, std::span(classified.str_values).subspan(i, count));
+            for (size_t j = i ; j < i + count ; ++j)
+                CheckPath(id, args[j], j);
+        }
+        ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(i), TraceDecision::kPositionalRun, arg}));
+
+        for (size_t j = i ; j < i + count ; ++j)
+            emit({ParseEventKind::kPositional, arg, args[j], j});
+        if (i + count < end) {
+            PrintTooManyValues(arg, args[i + count]);
+            emit({ParseEventKind::kError, arg, args[i + count], i + count});
+            return false;
+        }
 
-            for (size_t j = 1 ; j < args[i].size() - 1 ; ++j) {
-                std::string arg = MergeChars(args[i][0], args[i][j]);
+        i = end - 1;
+        return true;
+    }
 
-                if (flags_.KeyContains(arg)) {
-                    arg = flags_.GetByKey(arg);
-                }
+    const std::string_view next_token = i + 1 < separator ? args[i + 1] : std::string_view{};
+    const std::string_view* next = i + 1 < separator ? &next_token : nullptr;
+    bool is_next_used = false;
+    if (!ParseToken(args[i], next, i, is_next_used, emit))
+        return false;
+    i += is_next_used;
 
-                if (flags_.Contains(arg)) {
-                    if (flags_.IsStored(arg)) {
-                        *flags_.GetValue(arg) = true;
-                    } else {
-                        flags_.CreateValue(arg);
-                    }
-                } else {
-                    is_any_wrong_key = true;
-                    break;
-                }
-            }
+    return true;
+}
 
-            std::vector<std::string> cur_arg_config;
-            cur_arg_config.push_back(MergeChars(args[i][0], args[i].back()));
-            if (i + 1 < args.size())
-                cur_arg_config.push_back(args[i + 1]);
-            size_t delta = 0;
+void ArgParser::BeginParse() {
+    ARG_PARSER_TRACE(trace_.Clear());
+    WaitPathChecks();
+    path_checks_.clear();
+    int_args_.ResetValuesCount();
+    str_args_.ResetValuesCount();
+    seen_.Clear();
+}
 
-            if (const auto is_argument = this->IsArgument(cur_arg_config, delta) ; is_argument ==
-                ArgumentCheckStatus::kParsingFailure || is_argument ==
-                ArgumentCheckStatus::kIncorrectArgument)
-                return false;
+template<class Emit>
+bool ArgParser::ParseToken(const std::string_view token, const std::string_view* next, const size_t position,
+                           bool& is_next_used, Emit& emit) {
+    {
+        ParseEvent event{ParseEventKind::kError, {}, token, position};
+        const auto is_argument = this->IsArgument(token, next, is_next_used, event);
+        ARG_PARSER_TRACE(if (is_argument != ArgumentCheckStatus::kIncorrectArgument)
+                             TraceMatch(position, token, event.argument));
 
-            i += delta;
+        if (is_argument == ArgumentCheckStatus::kParsingFailure) {
+            emit({ParseEventKind::kError, event.argument, is_next_used ? *next : token,
+                              position + is_next_used});
+            return false;
+        }
 
-            if (is_any_wrong_key) {
-                PrintWarning("No such argument name, no any positional argument with same type:", args[i]);
+        if (is_argument == ArgumentCheckStatus::kCorrectArgument) {
+            emit(event);
+            return true;
+        }
+    }
+
+    //ArgumentCheckStatus::kIncorrectArgument
+    if (int result = 0 ; std::from_chars(token.data(), token.data() + token.size(), result).ec == std::errc{}
+                         && int_args_.IsPositional()) {
+        const size_t id = int_args_.GetPositional();
+        const std::string_view arg = int_args_.GetName(strings_, id);
+        if (!int_args_.IsValid(id, result)) {
+            PrintInvalidValue(arg, token);
+            emit({ParseEventKind::kError, arg, token, position});
+            return false;
+        }
+        if (int_args_.GetValuesLeft(id) == 0) {
+            PrintTooManyValues(arg, token);
+            emit({ParseEventKind::kError, arg, token, position});
+            return false;
+        }
+        seen_.Set(int_args_.GetBit(id));
+        int_args_.ReserveValues(id, remaining_tokens_);
+        int_args_.SetParcedArgument(id, result);
+        ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(position), TraceDecision::kPositional, arg}));
+        emit({ParseEventKind::kPositional, arg, token, position});
+    } else if (str_args_.IsPositional()) {
+        const size_t id = str_args_.GetPositional();
+        const std::string_view arg = str_args_.GetName(strings_, id);
+        if (!str_args_.IsValid(id, token)) {
+            PrintInvalidValue(arg, token);
+            emit({ParseEventKind::kError, arg, token, position});
+            return false;
+        }
+        if (str_args_.GetValuesLeft(id) == 0) {
+            PrintTooManyValues(arg, token);
+            emit({ParseEventKind::kError, arg, token, position});
+            return false;
+        }
+        seen_.Set(str_args_.GetBit(id));
+        str_args_.ReserveValues(id, remaining_tokens_);
+        if (!StoreString(id, token, position)) {
+            emit({ParseEventKind::kError, arg, token, position});
+            return false;
+        }
+        ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(position), TraceDecision::kPositional, arg}));
+        emit({ParseEventKind::kPositional, arg, token, position});
+    } else if (token.size() < 2 || (is_pass_through_ && !IsBundle(token))) {
+        ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(position), TraceDecision::kUnknown, {}}));
+        if (is_pass_through_) {
+            emit({ParseEventKind::kPassThrough, {}, token, position});
+            return true;
+        }
+        PrintWarning("No such argument name, no any positional argument with same type:", token);
+        emit({ParseEventKind::kError, {}, token, position});
+        return false;
+    } else {
+        // "-abc": every char except the last one is a flag key, the last one may take a value
+        std::string bundle_key(2, token[0]);
+        for (size_t j = 1 ; j + 1 < token.size() ; ++j) {
+            bundle_key[1] = token[j];
+            const size_t id = flags_.Find(strings_, bundle_key);
+
+            if (id == kNoArgument) {
+                ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(position), TraceDecision::kUnknown, {}}));
+                PrintWarning("No such argument name, no any positional argument with same type:", token);
+                emit({ParseEventKind::kError, {}, token, position});
                 return false;
             }
+
+            seen_.Set(flags_.GetBit(id));
+            flags_.SetParcedArgument(id);
+            ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(position), TraceDecision::kBundle,
+                                          flags_.GetName(strings_, id)}));
+            emit({ParseEventKind::kFlag, flags_.GetName(strings_, id), {}, position});
         }
+
+        ParseEvent event{ParseEventKind::kError, {}, token, position};
+        bundle_key[1] = token.back();
+
+        const auto is_argument = this->IsArgument(bundle_key, next, is_next_used, event);
+        ARG_PARSER_TRACE(trace_.Push({static_cast<uint32_t>(position),
+                                      is_argument == ArgumentCheckStatus::kIncorrectArgument
+                                          ? TraceDecision::kUnknown
+                                          : TraceDecision::kBundle,
+                                      event.argument}));
+        if (is_argument == ArgumentCheckStatus::kParsingFailure
+            || is_argument == ArgumentCheckStatus::kIncorrectArgument) {
+            is_next_used = false;
+            emit({ParseEventKind::kError, event.argument, token, position});
+            return false;
+        }
+
+        emit(event);
     }
 
-    return !IsUnusedNoDefaultArgument();
+    return true;
+}
+
+bool ArgParser::TakesNextToken(const std::string_view token) const {
+    const auto takes_value = [this](const std::string_view arg) {
+        return str_args_.Find(strings_, arg) != kNoArgument || int_args_.Find(strings_, arg) != kNoArgument
+               || enum_args_.Find(strings_, arg) != kNoArgument;
+    };
+
+    const size_t eq = token.find('=');
+    const std::string_view arg = token.substr(0, eq);
+    if (flags_.Find(strings_, arg) != kNoArgument)
+        return false;
+    if (takes_value(arg))
+        return eq == std::string_view::npos;
+
+    // The same fallbacks as ParseToken: positional values, passed through tokens, then a bundle
+    if (int result = 0 ; (std::from_chars(token.data(), token.data() + token.size(), result).ec == std::errc{}
+                          && int_args_.IsPositional())
+                         || str_args_.IsPositional() || token.size() < 2 || (is_pass_through_ && !IsBundle(token)))
+        return false;
+
+    const std::string key{token[0], token.back()};
+    return flags_.Find(strings_, key) == kNoArgument && takes_value(key);
+}
+
+bool ArgParser::FinishParse(const size_t end, ParseEvent& error) {
+    if (!ApplyEnvironment()) {
+        error = ParseEvent{ParseEventKind::kError, {}, {}, end};
+        return false;
+    }
+
+    WaitPathChecks();
+    const PathCheck* failed = nullptr;
+    for (const auto& check: path_checks_) {
+        if (check.error == PathError::kNone)
+            continue;
+        PrintPathError(check);
+        if (failed == nullptr)
+            failed = &check;
+    }
+    if (failed != nullptr) {
+        error = ParseEvent{ParseEventKind::kError, failed->argument, failed->path, failed->position};
+        return false;
+    }
+
+    if (IsUnusedNoDefaultArgument() || IsMissingMultiValues() || IsConstraintViolated()) {
+        error = ParseEvent{ParseEventKind::kError, {}, {}, end};
+        return false;
+    }
+
+    ResolveLazyDefaults();
+    return true;
+}
+
+PushParser::PushParser(ArgParser& parser)
+    : parser_(parser) {
+    if (parser_.IsArgumentCoincidence()) {
+        events_.push_back({ParseEventKind::kError, {}, {}, 0});
+        is_failed_ = true;
+        is_done_ = true;
+        return;
+    }
+    parser_.BeginParse();
+}
+
+std::span<const ParseEvent> PushParser::Feed(const std::string_view token) {
+    if (is_done_)
+        return {};
+
+    events_.clear();
+    const std::string_view value = tokens_.emplace_back(token);
+    const size_t position = tokens_.size();
+
+    if (is_separated_) {
+        events_.push_back({ParseEventKind::kPassThrough, {}, value, position});
+        return events_;
+    }
+    if (value == "--help" || value == "-h") {
+        parser_.is_added_help_ = true;
+        ARG_PARSER_TRACE(parser_.trace_.Push({static_cast<uint32_t>(position), TraceDecision::kHelp, value}));
+        events_.push_back({ParseEventKind::kHelp, value, {}, position});
+        is_done_ = true;
+        return events_;
+    }
+    if (parser_.is_pass_through_ && value == "--") {
+        is_separated_ = true;
+        if (IsPending())
+            Step(nullptr);
+        return events_;
+    }
+
+    if (IsPending()) {
+        Step(&value);
+        return events_;
+    }
+    if (parser_.TakesNextToken(value)) {
+        pending_ = position;
+        return events_;
+    }
+    pending_ = position;
+    Step(nullptr);
+
+    return events_;
+}
+
+std::span<const ParseEvent> PushParser::Finish() {
+    if (is_done_)
+        return events_;
+
+    events_.clear();
+    if (IsPending())
+        Step(nullptr);
+    if (!is_done_) {
+        if (ParseEvent error{} ; !parser_.FinishParse(tokens_.size() + 1, error)) {
+            events_.push_back(error);
+            is_failed_ = true;
+        }
+        is_done_ = true;
+    }
+
+    return events_;
+}
+
+bool PushParser::IsPending() const {
+    return pending_ != kNoArgument;
+}
+
+bool PushParser::IsFailed() const {
+    return is_failed_;
+}
+
+void PushParser::Step(const std::string_view* next) {
+    bool is_next_used = false;
+    parser_.remaining_tokens_ = 1;
+    auto append = [this](const ParseEvent& event) {
+        events_.push_back(event);
+    };
+    if (!parser_.ParseToken(tokens_[pending_ - 1], next, pending_, is_next_used, append)) {
+        parser_.WaitPathChecks();
+        is_failed_ = true;
+        is_done_ = true;
+    }
+    pending_ = kNoArgument;
+}
+
+bool ArgParser::ApplyEnvironment() {
+#ifdef __unix__
+    if (env_bindings_.empty())
+        return true;
+
+    for (char** entry = environ ; *entry != nullptr ; ++entry) {
+        if (std::strncmp(*entry, env_prefix_.data(), env_prefix_.size()) != 0)
+            continue;
+
+        const std::string_view variable(*entry);
+        const size_t eq = variable.find('=');
+        const uint32_t binding = env_index_.Find(strings_, variable.substr(0, eq));
+        if (eq == std::string_view::npos || binding == NameIndex::kNone)
+            continue;
+
+        const auto [type, id] = env_bindings_[binding];
+        const BaseArgumentConfig* config = GetConfig(type);
+        if (seen_.Test(config->GetBit(id)))
+            continue;
+
+        const std::string_view value = variable.substr(eq + 1);
+        if (!SetEnvValue(type, id, value)) {
+            std::cerr << "Warning: Invalid value in " << variable.substr(0, eq) << " for argument "
+                      << config->GetName(strings_, id) << ": " << value << '\n';
+            return false;
+        }
+        seen_.Set(config->GetBit(id));
+    }
+#endif
+
+    return true;
+}
+
+bool ArgParser::SetEnvValue(const ArgumentType type, const size_t id, const std::string_view value) {
+    switch (type) {
+        case ArgumentType::kFlag: {
+            static constexpr std::string_view kTrue[] = {"1", "true", "yes", "on"};
+            static constexpr std::string_view kFalse[] = {"", "0", "false", "no", "off"};
+            if (std::ranges::find(kTrue, value) != std::end(kTrue)) {
+                flags_.SetParcedArgument(id);
+                return true;
+            }
+            return std::ranges::find(kFalse, value) != std::end(kFalse);
+        }
+        case ArgumentType::kInt: {
+            int result;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+            if (ec != std::errc{} || end != value.data() + value.size() || !int_args_.IsValid(id, result)
+                || int_args_.GetValuesLeft(id) == 0)
+                return false;
+            int_args_.SetParcedArgument(id, result);
+            return true;
+        }
+        case ArgumentType::kString:
+            return str_args_.IsValid(id, value) && str_args_.GetValuesLeft(id) != 0
+                   && StoreString(id, value, kNoArgument);
+        case ArgumentType::kEnum:
+            return enum_args_.SetParcedArgument(id, value);
+        default:
+            return false;
+    }
+}
+
+void ArgParser::ResolveLazyDefaults() {
+    const ArgumentType type = cur_type_;
+    const size_t id = cur_id_;
+    for (auto& lazy: lazy_defaults_) {
+        if (!lazy.resolve || seen_.Test(GetConfig(lazy.type)->GetBit(lazy.id)))
+            continue;
+        // Default() acts on the current argument
+        cur_type_ = lazy.type;
+        cur_id_ = lazy.id;
+        lazy.resolve(*this);
+        lazy.resolve = SmallFunction<void(ArgParser&)>();
+    }
+    cur_type_ = type;
+    cur_id_ = id;
 }
 
 bool ArgParser::Parse(int argc, char** argv) {
-    return Parse({argv, argv + argc});
+    pass_through_args_.clear();
+    auto collect = [this, argv](const ParseEvent& event) {
+        if (event.kind == ParseEventKind::kPassThrough)
+            pass_through_args_.push_back(argv[event.position]);
+    };
+    if (IsArgumentCoincidence() || !ParseLine(TokenRange(argc, argv), collect)) {
+        pass_through_args_.clear();
+        return false;
+    }
+    pass_through_args_.push_back(nullptr);
+
+    return true;
+}
+
+std::span<char* const> ArgParser::PassThroughArgs() const {
+    if (pass_through_args_.empty())
+        return {};
+    return std::span(pass_through_args_).first(pass_through_args_.size() - 1);
+}
+
+#ifdef ARG_PARSER_ENABLE_TRACE
+void ArgParser::TraceMatch(const size_t token, const std::string_view arg, const std::string_view name) {
+    TraceDecision decision = TraceDecision::kKeyAlias;
+    if (arg.find('=') != std::string_view::npos)
+        decision = TraceDecision::kEqualsSplit;
+    else if (arg == name)
+        decision = TraceDecision::kExactMatch;
+    trace_.Push({static_cast<uint32_t>(token), decision, name});
+}
+
+const TraceBuffer& ArgParser::Trace() const {
+    return trace_;
 }
 
+void ArgParser::DumpTrace(std::ostream& out) const {
+    static constexpr std::string_view kDecisionNames[] = {
+        "help", "exact match", "key alias", "= split", "bundle", "positional", "positional run", "unknown"
+    };
+
+    if (trace_.Dropped() != 0)
+        out << "... " << trace_.Dropped() << " earlier decisions dropped\n";
+    for (size_t i = 0 ; i < trace_.Size() ; ++i) {
+        const TraceEvent& event = trace_[i];
+        out << '#' << event.token << ' ' << kDecisionNames[static_cast<size_t>(event.decision)];
+        if (!event.argument.empty())
+            out << " -> " << event.argument;
+        out << '\n';
+    }
+}
+#endif
+
+BatchResult ArgParser::ParseBatch(const std::span<const std::string_view> lines) const {
+    std::unique_ptr<ThreadPool> own_pool;
+    ThreadPool* pool = pool_.get();
+    if (pool == nullptr) {
+        own_pool = std::make_unique<ThreadPool>();
+        pool = own_pool.get();
+    }
+
+    BatchResult result;
+    result.lines.resize(lines.size());
+    const size_t chunks = (lines.size() + kBatchGrain - 1) / kBatchGrain;
+    std::vector<std::vector<ParseEvent>> chunk_events(chunks);
+    // Sized once: the deques are never moved, so views into their strings stay valid
+    result.unescaped.resize(chunks);
+    std::atomic<size_t> next_chunk = 0;
+
+    // The schema is checked once for the whole batch
+    if (IsArgumentCoincidence()) {
+        for (size_t i = 0 ; i < lines.size() ; ++i) {
+            result.lines[i] = {static_cast<uint32_t>(i), static_cast<uint32_t>(i + 1), false};
+            result.events.push_back({ParseEventKind::kError, {}, {}, 0});
+        }
+        return result;
+    }
+
+    // One schema copy, lexer and token buffer per worker, chunks of lines are taken dynamically.
+    // Events are appended to the chunk's buffer without a coroutine frame per line
+    pool->ParallelFor(std::min(pool->Size(), chunks), 1, [&](size_t, size_t) {
+        ArgParser parser(*this);
+        ShellLexer lexer;
+        std::vector<std::string_view> tokens;
+
+        for (size_t chunk = next_chunk++ ; chunk < chunks ; chunk = next_chunk++) {
+            auto& events = chunk_events[chunk];
+            auto& unescaped = result.unescaped[chunk];
+            for (size_t i = chunk * kBatchGrain ; i < std::min(lines.size(), (chunk + 1) * kBatchGrain) ; ++i) {
+                auto& line = result.lines[i];
+                line.begin = static_cast<uint32_t>(events.size());
+                if (!lexer.Split(lines[i], tokens)) {
+                    PrintWarning("Unterminated quote in command:", lines[i]);
+                    events.push_back({ParseEventKind::kError, {}, lines[i], 0});
+                    line.end = static_cast<uint32_t>(events.size());
+                    line.ok = false;
+                    continue;
+                }
+
+                parser.ResetValues();
+                auto append = [&events](const ParseEvent& event) {
+                    events.push_back(event);
+                };
+                line.ok = parser.ParseLine(tokens, append);
+                line.end = static_cast<uint32_t>(events.size());
+
+                // Values outside the line live in the lexer or the worker's parser, they are copied out
+                const std::less_equal<const char*> less_equal;
+                const std::string_view text = lines[i];
+                for (size_t j = line.begin ; j < line.end ; ++j) {
+                    auto& event = events[j];
+                    event.argument = parser.strings_.Translate(event.argument, strings_);
+                    if (!event.value.empty() && (!less_equal(text.data(), event.value.data())
+                                                 || !less_equal(event.value.data() + event.value.size(),
+                                                                text.data() + text.size())))
+                        event.value = unescaped.emplace_back(event.value);
+                }
+            }
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& events: chunk_events)
+        total += events.size();
+    result.events.reserve(total);
+
+    for (size_t chunk = 0 ; chunk < chunks ; ++chunk) {
+        const auto offset = static_cast<uint32_t>(result.events.size());
+        for (size_t i = chunk * kBatchGrain ; i < std::min(lines.size(), (chunk + 1) * kBatchGrain) ; ++i) {
+            result.lines[i].begin += offset;
+            result.lines[i].end += offset;
+        }
+        result.events.insert(result.events.end(), chunk_events[chunk].begin(), chunk_events[chunk].end());
+    }
+
+    return result;
+}
+
+BatchResult ArgParser::ParseBatch(const std::vector<std::string>& lines) const {
+    const std::vector<std::string_view> views(lines.begin(), lines.end());
+    return ParseBatch(views);
+}
+
+std::span<const ParseEvent> BatchResult::Events(const size_t line) const {
+    return std::span(events).subspan(lines[line].begin, lines[line].end - lines[line].begin);
+}
+
+ArgParser& ArgParser::Range(const int min, const int max) {
+    if (cur_type_ == ArgumentType::kInt) {
+        int_args_.SetRange(cur_id_, min, max);
+    } else {
+        PrintError("Try set range for non-int argument", GetCurrentName());
+    }
+
+    return *this;
+}
+
+ArgParser& ArgParser::Choices(const std::initializer_list<int> choices) {
+    if (cur_type_ == ArgumentType::kInt) {
+        int_args_.SetChoices(cur_id_, choices);
+    } else {
+        PrintError("Try set int choices for non-int argument", GetCurrentName());
+    }
+
+    return *this;
+}
+
+ArgParser& ArgParser::Choices(const std::initializer_list<std::string_view> choices) {
+    if (cur_type_ == ArgumentType::kString) {
+        str_args_.SetChoices(cur_id_, choices);
+    } else {
+        PrintError("Try set string choices for non-string argument", GetCurrentName());
+    }
+
+    return *this;
+}
+
+ArgParser& ArgParser::Matches(const std::string& pattern) {
+    if (cur_type_ == ArgumentType::kString) {
+        str_args_.SetPattern(cur_id_, pattern);
+    } else {
+        PrintError("Try set pattern for non-string argument", GetCurrentName());
+    }
+
+    return *this;
+}
+
+ArgParser& ArgParser::Utf8() {
+    if (cur_type_ == ArgumentType::kString) {
+        str_args_.SetUtf8(cur_id_);
+    } else {
+        PrintError("Try set UTF-8 check for non-string argument", GetCurrentName());
+    }
+
+    return *this;
+}
+
+ArgParser& ArgParser::Glob() {
+    if (cur_type_ != ArgumentType::kString || str_args_.IsMap(cur_id_) || str_args_.IsRangeSet(cur_id_)) {
+        PrintError("Try set glob expansion for non-string argument", GetCurrentName());
+    } else if (!str_args_.IsMultiValueArgument(cur_id_)) {
+        // A pattern may match many paths, a single value argument would silently keep only the last one
+        PrintError("Try set glob expansion for single value argument, call MultiValue() first", GetCurrentName());
+    } else {
+        str_args_.SetGlob(cur_id_);
+    }
+
+    return *this;
+}
+
+ArgParser& ArgParser::Env(const std::string_view variable) {
+    const BaseArgumentConfig* config = GetConfig(cur_type_);
+    if (config == nullptr) {
+        PrintError("Try set environment variable before adding an argument", variable);
+        return *this;
+    }
+
+    const StringPool::Ref ref = strings_.Add(variable);
+    env_index_.Insert(strings_, ref, static_cast<uint32_t>(env_bindings_.size()));
+    env_bindings_.push_back({cur_type_, cur_id_});
+    if (env_bindings_.size() == 1)
+        env_prefix_ = variable;
+    else
+        env_prefix_.resize(std::ranges::mismatch(env_prefix_, variable).in1 - env_prefix_.begin());
+
+    return *this;
+}
+
+ArgParser& ArgParser::MustExist() {
+    AddPathChecks(PathCheck::kMustExist);
+    return *this;
+}
+
+ArgParser& ArgParser::IsDirectory() {
+    AddPathChecks(PathCheck::kMustExist | PathCheck::kIsDirectory);
+    return *this;
+}
+
+ArgParser& ArgParser::Readable() {
+    AddPathChecks(PathCheck::kMustExist | PathCheck::kReadable);
+    return *this;
+}
+
+void ArgParser::AddPathChecks(const uint8_t checks) {
+    if (cur_type_ == ArgumentType::kString && str_args_.IsPath(cur_id_)) {
+        str_args_.AddPathChecks(cur_id_, checks);
+    } else {
+        PrintError("Try set path check for non-path argument", GetCurrentName());
+    }
+}
+
+void ArgParser::CheckPath(const size_t id, const std::string_view path, const size_t position) {
+    const uint8_t checks = str_args_.GetPathChecks(id);
+    if (checks == 0)
+        return;
+
+    // The deque keeps the check in place while more are added
+    PathCheck& check = path_checks_.emplace_back(PathCheck{str_args_.GetName(strings_, id), std::string(path),
+                                                           position, checks});
+    GetIoPool().Submit([&check] { check.error = CheckFileSystem(check.path, check.checks); });
+}
+
+void ArgParser::WaitPathChecks() {
+    if (path_checks_.empty())
+        return;
+    if (pool_ != nullptr)
+        pool_->Wait();
+    if (io_pool_ != nullptr)
+        io_pool_->Wait();
+}
+
+ThreadPool& ArgParser::GetIoPool() {
+    if (pool_ != nullptr)
+        return *pool_;
+    if (io_pool_ == nullptr)
+        io_pool_ = std::make_unique<ThreadPool>(kIoThreads);
+    return *io_pool_;
+}
+
+bool ArgParser::StoreString(const size_t id, const std::string_view value, const size_t position) {
+    // Range expressions are parsed once, straight into the set, so a malformed one is found here
+    if (str_args_.IsRangeSet(id)) {
+        if (str_args_.SetParcedRanges(id, value))
+            return true;
+        PrintInvalidValue(str_args_.GetName(strings_, id), value);
+        return false;
+    }
+
+    if (!str_args_.IsGlob(id) || !IsGlobPattern(value)) {
+        str_args_.SetParcedArgument(id, value);
+        CheckPath(id, value, position);
+        return true;
+    }
+
+    // Matches go straight into the values, the walk stops at the count the argument has left
+    std::vector<std::string>& values = str_args_.GetValues(id);
+    const size_t begin = values.size();
+    if (!ArgumentParser::Glob(value, GetIoPool(), str_args_.GetValuesLeft(id), values)) {
+        values.resize(begin);
+        PrintTooManyValues(str_args_.GetName(strings_, id), value);
+        return false;
+    }
+    if (values.size() == begin) {
+        // like sh, a pattern without matches is kept as it is
+        str_args_.SetParcedArgument(id, value);
+        CheckPath(id, value, position);
+        return true;
+    }
+
+    str_args_.SetParcedValues(id, begin);
+    for (size_t i = begin ; i < values.size() ; ++i)
+        CheckPath(id, values[i], position);
+
+    return true;
+}
+
+const std::deque<PathCheck>& ArgParser::PathChecks() const {
+    return path_checks_;
+}
+
+ArgParser& ArgParser::Parallel(const size_t threads) {
+    pool_ = std::make_unique<ThreadPool>(threads);
+    return *this;
+}
+
+ArgParser& ArgParser::PassThrough() {
+    is_pass_through_ = true;
+    return *this;
+}
+
+bool ArgParser::IsBundle(const std::string_view token) const {
+    std::string key(2, token[0]);
+    for (size_t i = 1 ; i + 1 < token.size() ; ++i) {
+        key[1] = token[i];
+        if (flags_.Find(strings_, key) == kNoArgument)
+            return false;
+    }
+    key[1] = token.back();
+
+    return IsArgumentName(key);
+}
+
+bool ArgParser::IsArgumentName(const std::string_view token) const {
+    const std::string_view arg = token.substr(0, token.find('='));
+
+    return flags_.Find(strings_, arg) != kNoArgument || str_args_.Find(strings_, arg) != kNoArgument
+           || int_args_.Find(strings_, arg) != kNoArgument || enum_args_.Find(strings_, arg) != kNoArgument;
+}
+
+// Same decision as the sequential pass takes for a token which is not consumed as a value
+TokenKind ArgParser::ClassifyToken(const std::string_view token, int& value) const {
+    if (IsArgumentName(token))
+        return TokenKind::kArgument;
+
+    if (std::from_chars(token.data(), token.data() + token.size(), value).ec == std::errc{}
+        && int_args_.IsPositional()) {
+        return int_args_.IsValid(int_args_.GetPositional(), value)
+                   ? TokenKind::kIntPositional
+                   : TokenKind::kInvalidPositional;
+    }
+
+    if (str_args_.IsPositional()) {
+        // Patterns are expanded and range expressions are parsed by the sequential pass
+        if ((str_args_.IsGlob(str_args_.GetPositional()) && IsGlobPattern(token))
+            || str_args_.IsRangeSet(str_args_.GetPositional()))
+            return TokenKind::kOther;
+        return str_args_.IsValid(str_args_.GetPositional(), token)
+                   ? TokenKind::kStringPositional
+                   : TokenKind::kInvalidPositional;
+    }
+
+    return TokenKind::kOther;
+}
+
+void ArgParser::ClassifyTokens(const TokenRange args, ClassifiedTokens& classified) const {
+    if (pool_ == nullptr || args.Size() < kMinParallelTokens
+        || (!int_args_.IsPositional() && !str_args_.IsPositional()))
+        return;
+
+    auto& kinds = classified.kinds;
+    auto& int_values = classified.int_values;
+    auto& str_values = classified.str_values;
+    kinds.assign(args.Size(), TokenKind::kArgument);
+    int_values.assign(args.Size(), 0);
+    str_values.assign(args.Size(), {});
+
+    pool_->ParallelFor(args.Size() - 1, kParallelGrain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin + 1 ; i < end + 1 ; ++i) {
+            kinds[i] = ClassifyToken(args[i], int_values[i]);
+            if (kinds[i] == TokenKind::kStringPositional)
+                str_values[i] = args[i];
+        }
+    });
+}
+
+
 ArgParser& ArgParser::AddHelp(const std::string& desc) {
     // is_added_help_ = true;
-    return AddFlag("-h", "--help", desc);
+    AddFlag("-h", "--help", desc);
+    MakeOptional();
+    return *this;
 }
 
 ArgParser& ArgParser::AddFlag(const std::string& key,
                               const std::string& name,
                               const std::string& desc) {
-    cur_arg_ = name;
-    flags_.SetArgument(key, name, desc);
+    const size_t size = flags_.Size();
+    cur_type_ = ArgumentType::kFlag;
+    cur_id_ = flags_.SetArgument(strings_, key, name, desc);
+    RegisterArgument(flags_, size);
     return *this;
 }
 
@@ -140,37 +1053,53 @@ ArgParser& ArgParser::AddFlag(const std::string& name, const std::string& desc)
 }
 
 ArgParser& ArgParser::StoreValue(bool& value) {
-    flags_.PutValue(cur_arg_, &value);
+    if (cur_type_ == ArgumentType::kFlag) {
+        flags_.PutValue(cur_id_, &value);
+        MakeOptional();
+    } else {
+        PrintError("Try store flag value of non-flag argument", GetCurrentName());
+    }
     return *this;
 }
 
 std::string ArgParser::HelpDescription() const {
     std::stringstream out;
 
-    if (!flags_.Contains("--help")) {
+    const size_t help = flags_.Find(strings_, "--help");
+    if (help == kNoArgument) {
         out << "No help info provided";
         return out.str();
     }
 
     out << program_name_ << '\n';
-    out << flags_.GetDescription("--help") << '\n';
+    out << flags_.GetDescription(strings_, help) << '\n';
     out << '\n';
 
-    const auto& ints = int_args_.GetUsedArgumentsList();
-    const auto& strings = str_args_.GetUsedArgumentsList();
-    const auto& flags = flags_.GetUsedArgumentsList();
+    for (const size_t id: int_args_.GetSortedArguments(strings_)) {
+        out << int_args_.GetArgumentHelpDescription(strings_, "int", id) << int_args_.GetExtraArgumentsDescription(id)
+            << "\n";
+    }
 
-    for (auto& arg: ints) {
-        out << int_args_.GetArgumentHelpDescription("int", arg) << int_args_.GetExtraArgumentsDescription(arg) << "\n";
+    for (const size_t id: str_args_.GetSortedArguments(strings_)) {
+        std::string_view type = "string";
+        if (str_args_.IsMap(id))
+            type = "key=value";
+        else if (str_args_.IsRangeSet(id))
+            type = "ranges";
+        else if (str_args_.IsPath(id))
+            type = "path";
+        out << str_args_.GetArgumentHelpDescription(strings_, type, id) << str_args_.GetExtraArgumentsDescription(id)
+            << "\n";
     }
 
-    for (auto& arg: strings) {
-        out << str_args_.GetArgumentHelpDescription("string", arg) << str_args_.GetExtraArgumentsDescription(arg) <<
-            "\n";
+    for (const size_t id: enum_args_.GetSortedArguments(strings_)) {
+        out << enum_args_.GetArgumentHelpDescription(strings_, enum_args_.GetChoices(strings_, id), id)
+            << enum_args_.GetExtraArgumentsDescription(id) << "\n";
     }
 
-    for (auto& arg: flags) {
-        out << flags_.GetArgumentHelpDescription("flag", arg) << flags_.GetExtraArgumentsDescription(arg) << "\n";
+    for (const size_t id: flags_.GetSortedArguments(strings_)) {
+        out << flags_.GetArgumentHelpDescription(strings_, "flag", id) << flags_.GetExtraArgumentsDescription(id)
+            << "\n";
     }
 
     // out << flags_.GetArgumentsHelpDescription("")
@@ -179,127 +1108,434 @@ std::string ArgParser::HelpDescription() const {
 }
 
 ArgParser& ArgParser::Default(const int value) {
-    int_args_.SetDefault(cur_arg_, value);
+    if (cur_type_ == ArgumentType::kInt) {
+        int_args_.SetDefault(cur_id_, value);
+        MakeOptional();
+    } else {
+        PrintError("Try set int default of non-int argument", GetCurrentName());
+    }
     return *this;
 }
 ArgParser& ArgParser::Default(const bool value) {
-    flags_.SetDefault(cur_arg_, value);
+    if (cur_type_ == ArgumentType::kFlag) {
+        flags_.SetDefault(cur_id_, value);
+        MakeOptional();
+    } else {
+        PrintError("Try set flag default of non-flag argument", GetCurrentName());
+    }
     return *this;
 }
 ArgParser& ArgParser::Default(const char* value) {
-    str_args_.SetDefault(cur_arg_, value);
+    if (cur_type_ == ArgumentType::kString) {
+        str_args_.SetDefault(cur_id_, value);
+        MakeOptional();
+    } else {
+        PrintError("Try set string default of non-string argument", GetCurrentName());
+    }
     return *this;
 }
 
 bool ArgParser::IsArgumentCoincidence() const {
-    std::vector<std::string_view> ins1, ins2, ins3;
-    auto flags = flags_.GetUsedArgumentsList();
-    auto ints = int_args_.GetUsedArgumentsList();
-    auto strs = str_args_.GetUsedArgumentsList();
-    std::ranges::set_intersection(flags, ints, std::back_inserter(ins1));
-    std::ranges::set_intersection(flags, strs, std::back_inserter(ins2));
-    std::ranges::set_intersection(ints, strs, std::back_inserter(ins3));
-    return !ins1.empty() || !ins2.empty() || !ins3.empty();
+    return is_coincidence_;
+}
+
+std::string_view ArgParser::GetCurrentName() const {
+    const BaseArgumentConfig* config = GetConfig(cur_type_);
+    return config != nullptr ? config->GetName(strings_, cur_id_) : std::string_view();
+}
+
+const BaseArgumentConfig* ArgParser::GetConfig(const ArgumentType type) const {
+    switch (type) {
+        case ArgumentType::kFlag:
+            return &flags_;
+        case ArgumentType::kInt:
+            return &int_args_;
+        case ArgumentType::kString:
+            return &str_args_;
+        case ArgumentType::kEnum:
+            return &enum_args_;
+        default:
+            return nullptr;
+    }
+}
+
+BaseArgumentConfig* ArgParser::GetConfig(const ArgumentType type) {
+    return const_cast<BaseArgumentConfig*>(std::as_const(*this).GetConfig(type));
+}
+
+void ArgParser::RegisterArgument(BaseArgumentConfig& config, const size_t size) {
+    if (config.Size() == size)
+        return; // the name was added before
+
+    // Names are unique inside one config, so a repeat can only come from another type
+    const std::string_view name = config.GetName(strings_, cur_id_);
+    for (const BaseArgumentConfig* other: {static_cast<const BaseArgumentConfig*>(&flags_),
+                                           static_cast<const BaseArgumentConfig*>(&int_args_),
+                                           static_cast<const BaseArgumentConfig*>(&str_args_),
+                                           static_cast<const BaseArgumentConfig*>(&enum_args_)}) {
+        if (other != &config && other->Find(strings_, name) != kNoArgument)
+            is_coincidence_ = true;
+    }
+
+    const size_t bit = arguments_.size();
+    config.SetBit(cur_id_, bit);
+    arguments_.emplace_back(cur_type_, cur_id_);
+    required_.Set(bit);
+    seen_.Resize(bit + 1);
+}
+
+void ArgParser::MakeOptional() {
+    required_.Reset(GetConfig(cur_type_)->GetBit(cur_id_));
+}
+
+size_t ArgParser::FindBit(const std::string_view name) const {
+    for (const auto type: {ArgumentType::kFlag, ArgumentType::kInt, ArgumentType::kString, ArgumentType::kEnum}) {
+        const BaseArgumentConfig* config = GetConfig(type);
+        if (const size_t id = config->Find(strings_, name) ; id != kNoArgument)
+            return config->GetBit(id);
+    }
+    return BitSet::kNone;
+}
+
+std::string_view ArgParser::GetBitName(const size_t bit) const {
+    const auto [type, id] = arguments_[bit];
+    return GetConfig(type)->GetName(strings_, id);
 }
 
-ArgumentCheckStatus ArgParser::IsArgument(const std::vector<std::string>& args, size_t& i) {
-    std::string arg = args[i].substr(0, args[i].find('='));
-    std::string value = args[i].substr(args[i].find('=') + 1);
+ArgParser& ArgParser::MutuallyExclusive(const std::initializer_list<std::string_view> names) {
+    BitSet group;
+    for (const auto name: names) {
+        const size_t bit = FindBit(name);
+        if (bit == BitSet::kNone) {
+            PrintError("No such argument for mutually exclusive group:", name);
+            return *this;
+        }
+        group.Set(bit);
+    }
+    exclusive_groups_.push_back(std::move(group));
+
+    return *this;
+}
 
-    if (flags_.KeyContains(arg)) {
-        arg = flags_.GetByKey(arg);
+ArgParser& ArgParser::Requires(const std::string_view name) {
+    const size_t bit = FindBit(name);
+    if (cur_type_ == ArgumentType::kNone || bit == BitSet::kNone) {
+        PrintError("No such argument to require:", name);
+        return *this;
     }
 
-    if (flags_.Contains(arg)) {
-        if (flags_.IsStored(arg)) {
-            *flags_.GetValue(arg) = true;
+    BitSet required;
+    required.Set(bit);
+    requirements_.emplace_back(GetConfig(cur_type_)->GetBit(cur_id_), std::move(required));
+
+    return *this;
+}
+
+int ArgParser::ExportResults() {
+    SharedResults::Writer writer;
+    std::vector<uint32_t> slots;
+
+    slots.resize(flags_.Size());
+    for (size_t id = 0 ; id < flags_.Size() ; ++id)
+        slots[id] = writer.AddFlag(flags_.GetValue(id));
+    flags_.ForEachName(strings_, [&](const std::string_view name, const size_t id) {
+        writer.AddName(name, slots[id]);
+    });
+
+    slots.resize(int_args_.Size());
+    for (size_t id = 0 ; id < int_args_.Size() ; ++id) {
+        slots[id] = int_args_.IsMultiValueArgument(id)
+                        ? writer.AddInts(int_args_.GetValues(id))
+                        : writer.AddInts(std::span(&int_args_.GetValue(id), 1));
+    }
+    int_args_.ForEachName(strings_, [&](const std::string_view name, const size_t id) {
+        writer.AddName(name, slots[id]);
+    });
+
+    slots.resize(str_args_.Size());
+    std::vector<std::string> values;
+    for (size_t id = 0 ; id < str_args_.Size() ; ++id) {
+        // Maps are exported as sorted "key=value" strings, range sets as their "first-last" intervals
+        values.clear();
+        if (str_args_.IsMap(id)) {
+            str_args_.GetMap(id).ForEach([&values](const std::string_view key, const std::string_view value) {
+                values.push_back(std::string(key) + '=' + std::string(value));
+            });
+            std::ranges::sort(values);
+            slots[id] = writer.AddStrings(values);
+        } else if (str_args_.IsRangeSet(id)) {
+            for (const auto [first, last]: str_args_.GetRangeSet(id).Intervals())
+                values.push_back(first == last ? std::to_string(first)
+                                               : std::to_string(first) + '-' + std::to_string(last));
+            slots[id] = writer.AddStrings(values);
         } else {
-            flags_.CreateValue(arg);
+            slots[id] = str_args_.IsMultiValueArgument(id)
+                            ? writer.AddStrings(str_args_.GetValues(id))
+                            : writer.AddString(str_args_.GetValue(id));
         }
+    }
+    str_args_.ForEachName(strings_, [&](const std::string_view name, const size_t id) {
+        writer.AddName(name, slots[id]);
+    });
+
+    slots.resize(enum_args_.Size());
+    for (size_t id = 0 ; id < enum_args_.Size() ; ++id)
+        slots[id] = writer.AddString(enum_args_.GetValueName(id));
+    enum_args_.ForEachName(strings_, [&](const std::string_view name, const size_t id) {
+        writer.AddName(name, slots[id]);
+    });
+
+    const int fd = writer.Export();
+    if (fd == -1)
+        PrintError("Can't export results to shared memory", program_name_);
+    return fd;
+}
+
+MemoryFootprintReport ArgParser::MemoryFootprint() const {
+    MemoryFootprintReport report;
+    report.strings = strings_.MemoryFootprint();
+    report.arguments += arguments_.capacity() * sizeof(arguments_[0]) + required_.MemoryFootprint()
+            + seen_.MemoryFootprint();
+    flags_.AddMemoryFootprint(report);
+    int_args_.AddMemoryFootprint(report);
+    str_args_.AddMemoryFootprint(report);
+    enum_args_.AddMemoryFootprint(report);
+    return report;
+}
+
+ArgumentCheckStatus ArgParser::IsArgument(const std::string_view token, const std::string_view* next,
+                                          bool& is_next_used, ParseEvent& event) {
+    const size_t eq = token.find('=');
+    const bool has_value = eq != std::string_view::npos;
+    const std::string_view arg = token.substr(0, eq);
+    const std::string_view value = has_value ? token.substr(eq + 1) : std::string_view();
+
+    if (const size_t id = flags_.Find(strings_, arg) ; id != kNoArgument) {
+        seen_.Set(flags_.GetBit(id));
+        flags_.SetParcedArgument(id);
+        event.kind = ParseEventKind::kFlag;
+        event.argument = flags_.GetName(strings_, id);
+        event.value = {};
         return ArgumentCheckStatus::kCorrectArgument;
     }
 
-    if (str_args_.Contains(arg) || str_args_.KeyContains(arg)) {
-        // const auto stored = str_args_.GetValue(arg);
-        if (arg == args[i]) {
-            arg = str_args_.GetByKey(arg);
-            ++i;
-            if (i < args.size()) {
-                value = args[i];
-            } else if (!str_args_.IsDefault(arg)) {
+    if (const size_t id = str_args_.Find(strings_, arg) ; id != kNoArgument) {
+        seen_.Set(str_args_.GetBit(id));
+        const std::string_view name = str_args_.GetName(strings_, id);
+        event.kind = ParseEventKind::kValue;
+        event.argument = name;
+        event.value = {};
+
+        if (!has_value && next == nullptr) {
+            if (!str_args_.IsDefault(id)) {
                 PrintWarning("Non-default argument missing value");
 
                 return ArgumentCheckStatus::kParsingFailure;
             }
+            return ArgumentCheckStatus::kCorrectArgument;
         }
 
-        str_args_.SetParcedArgument(arg, value);
+        is_next_used = !has_value;
+        const std::string_view str = has_value ? value : *next;
+        if (!str_args_.IsValid(id, str)) {
+            PrintInvalidValue(name, str);
+
+            return ArgumentCheckStatus::kParsingFailure;
+        }
+        if (str_args_.GetValuesLeft(id) == 0) {
+            PrintTooManyValues(name, str);
+
+            return ArgumentCheckStatus::kParsingFailure;
+        }
+        str_args_.ReserveValues(id, remaining_tokens_);
+        if (!StoreString(id, str, event.position + is_next_used))
+            return ArgumentCheckStatus::kParsingFailure;
+        event.value = str;
 
         return ArgumentCheckStatus::kCorrectArgument;
     }
-    if (int_args_.Contains(arg) || int_args_.KeyContains(arg)) {
-        int res;
-        if (arg == args[i]) {
-            arg = int_args_.GetByKey(arg);
-            ++i;
-            if (i < args.size()) {
-                auto [_, ec] = std::from_chars(args[i].data(), args[i].data() + args[i].size(), res);
-                if (ec == std::errc::invalid_argument) {
-                    PrintWarning("Given string instead int positional argument");
+    if (const size_t id = int_args_.Find(strings_, arg) ; id != kNoArgument) {
+        seen_.Set(int_args_.GetBit(id));
+        const std::string_view name = int_args_.GetName(strings_, id);
+        event.kind = ParseEventKind::kValue;
+        event.argument = name;
+        event.value = {};
+
+        std::string_view number = value;
+        if (!has_value) {
+            if (next == nullptr) {
+                if (!int_args_.IsDefault(id)) {
+                    PrintWarning("Non-default argument missing value");
 
                     return ArgumentCheckStatus::kParsingFailure;
                 }
-                if (ec == std::errc::result_out_of_range) {
-                    PrintWarning("Given number more than an int");
+                return ArgumentCheckStatus::kCorrectArgument;
+            }
+            is_next_used = true;
+            number = *next;
+        }
 
-                    return ArgumentCheckStatus::kParsingFailure;
-                }
-            } else if (!int_args_.IsDefault(arg)) {
+        int res;
+        auto [_, ec] = std::from_chars(number.data(), number.data() + number.size(), res);
+        if (ec == std::errc::invalid_argument) {
+            PrintWarning(has_value ? "Not a number given as int argument" : "Given string instead int positional argument");
+
+            return ArgumentCheckStatus::kParsingFailure;
+        }
+        if (ec == std::errc::result_out_of_range) {
+            PrintWarning("Given number more than an int");
+
+            return ArgumentCheckStatus::kParsingFailure;
+        }
+        if (!int_args_.IsValid(id, res)) {
+            PrintInvalidValue(name, number);
+
+            return ArgumentCheckStatus::kParsingFailure;
+        }
+        if (int_args_.GetValuesLeft(id) == 0) {
+            PrintTooManyValues(name, number);
+
+            return ArgumentCheckStatus::kParsingFailure;
+        }
+        int_args_.ReserveValues(id, remaining_tokens_);
+        int_args_.SetParcedArgument(id, res);
+        event.value = number;
+
+        return ArgumentCheckStatus::kCorrectArgument;
+    }
+    if (const size_t id = enum_args_.Find(strings_, arg) ; id != kNoArgument) {
+        seen_.Set(enum_args_.GetBit(id));
+        event.kind = ParseEventKind::kValue;
+        event.argument = enum_args_.GetName(strings_, id);
+        event.value = {};
+
+        if (!has_value && next == nullptr) {
+            if (!enum_args_.IsDefault(id)) {
                 PrintWarning("Non-default argument missing value");
 
                 return ArgumentCheckStatus::kParsingFailure;
             }
-        } else {
-            auto [_, ec] = std::from_chars(value.data(), value.data() + value.size(), res);
-            if (ec == std::errc::invalid_argument) {
-                PrintWarning("Not a number given as int argument");
+            return ArgumentCheckStatus::kCorrectArgument;
+        }
 
-                return ArgumentCheckStatus::kParsingFailure;
-            }
-            if (ec == std::errc::result_out_of_range) {
-                PrintWarning("Given number more than an int");
+        is_next_used = !has_value;
+        const std::string_view name = has_value ? value : *next;
+        if (!enum_args_.SetParcedArgument(id, name)) {
+            PrintInvalidValue(event.argument, name);
 
-                return ArgumentCheckStatus::kParsingFailure;
-            }
+            return ArgumentCheckStatus::kParsingFailure;
         }
-        int_args_.SetParcedArgument(arg, res);
+        event.value = name;
 
         return ArgumentCheckStatus::kCorrectArgument;
     }
 
-    return ArgumentCheckStatus::kIncorrectArgument;
+    return ArgumentCheckStatus::kIncorrectArgument;
+}
+
+bool ArgParser::IsUnusedNoDefaultArgument() const {
+    BitSet missing = required_;
+    missing.AndNot(seen_);
+    if (const size_t bit = missing.FindNext(0) ; bit != BitSet::kNone) {
+        PrintWarning("Missing required argument", GetBitName(bit));
+        return true;
+    }
+
+    return false;
+}
+
+bool ArgParser::IsConstraintViolated() const {
+    for (const auto& group: exclusive_groups_) {
+        BitSet given = group;
+        given &= seen_;
+        if (given.Count() > 1) {
+            const size_t first = given.FindNext(0);
+            PrintWarning("Mutually exclusive arguments given:",
+                         std::string(GetBitName(first)) + " " + std::string(GetBitName(given.FindNext(first + 1))));
+            return true;
+        }
+    }
+
+    for (const auto& [bit, required]: requirements_) {
+        if (!seen_.Test(bit))
+            continue;
+
+        BitSet missing = required;
+        missing.AndNot(seen_);
+        if (missing.Any()) {
+            PrintWarning("Argument requires", std::string(GetBitName(bit)) + " " +
+                                              std::string(GetBitName(missing.FindNext(0))));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ArgParser::IsMissingMultiValues() const {
+    for (size_t id = 0 ; id < int_args_.Size() ; ++id) {
+        if (!int_args_.HasEnoughValues(id)) {
+            PrintWarning("Not enough values for argument", int_args_.GetName(strings_, id));
+            return true;
+        }
+    }
+
+    for (size_t id = 0 ; id < str_args_.Size() ; ++id) {
+        if (!str_args_.HasEnoughValues(id)) {
+            PrintWarning("Not enough values for argument", str_args_.GetName(strings_, id));
+            return true;
+        }
+    }
+
+    return false;
 }
 
-bool ArgParser::IsUnusedNoDefaultArgument() const {
-    const auto& ints = int_args_.GetUsedArgumentsList();
-    const auto& strings = str_args_.GetUsedArgumentsList();
-    const auto& flags = flags_.GetUsedArgumentsList();
+ArgParser& ArgParser::AddPathArgument(const std::string& key,
+                                      const std::string& name,
+                                      const std::string& desc) {
+    AddStringArgument(key, name, desc);
+    str_args_.MakePath(cur_id_);
+    return *this;
+}
 
-    bool is_any_unused_nodefault = false;
+ArgParser& ArgParser::AddPathArgument(const std::string& name, const std::string& desc) {
+    return AddPathArgument("", name, desc);
+}
 
-    for (auto& arg: ints) {
-        is_any_unused_nodefault |= !int_args_.IsDefault(arg) && !int_args_.IsStored(arg);
-    }
+ArgParser& ArgParser::AddRangeArgument(const std::string& key,
+                                       const std::string& name,
+                                       const std::string& desc) {
+    AddStringArgument(key, name, desc);
+    str_args_.MakeRangeSet(cur_id_);
+    MakeOptional();
+    return *this;
+}
 
-    for (auto& arg: strings) {
-        is_any_unused_nodefault |= !str_args_.IsDefault(arg) && !str_args_.IsStored(arg);
-    }
+ArgParser& ArgParser::AddRangeArgument(const std::string& name, const std::string& desc) {
+    return AddRangeArgument("", name, desc);
+}
+
+ArgParser& ArgParser::AddMapArgument(const std::string& key,
+                                     const std::string& name,
+                                     const std::string& desc) {
+    AddStringArgument(key, name, desc);
+    str_args_.MakeMap(cur_id_);
+    MakeOptional();
+    return *this;
+}
 
-    for (auto& arg: flags) {
-        is_any_unused_nodefault |= !flags_.IsDefault(arg) && !flags_.IsStored(arg) && arg != "--help";
+ArgParser& ArgParser::AddMapArgument(const std::string& name, const std::string& desc) {
+    return AddMapArgument("", name, desc);
+}
+
+ArgParser& ArgParser::UniqueKeys() {
+    if (cur_type_ == ArgumentType::kString && str_args_.IsMap(cur_id_)) {
+        str_args_.SetUniqueKeys(cur_id_);
+    } else {
+        PrintError("Try set unique keys for non-map argument", GetCurrentName());
     }
 
-    return is_any_unused_nodefault;
+    return *this;
 }
 
 ArgParser& ArgParser::AddStringArgument(const std::string& name,
@@ -310,61 +1546,192 @@ ArgParser& ArgParser::AddStringArgument(const std::string& name,
 ArgParser& ArgParser::AddStringArgument(const std::string& key,
                                         const std::string& name,
                                         const std::string& desc) {
-    cur_arg_ = name;
-    str_args_.SetArgument(key, name, desc);
+    const size_t size = str_args_.Size();
+    cur_type_ = ArgumentType::kString;
+    cur_id_ = str_args_.SetArgument(strings_, key, name, desc);
+    RegisterArgument(str_args_, size);
     return *this;
 }
 
 ArgParser& ArgParser::StoreValue(std::string& value) {
-    str_args_.PutValue(cur_arg_, &value);
+    if (cur_type_ == ArgumentType::kString) {
+        str_args_.PutValue(cur_id_, &value);
+        MakeOptional();
+    } else {
+        PrintError("Try store string value of non-string argument", GetCurrentName());
+    }
     return *this;
 }
 
-ArgParser& ArgParser::MultiValue(uint min_count) {
-    if (int_args_.Contains(cur_arg_))
-        int_args_.MakeMulti(cur_arg_);
-    else if (str_args_.Contains(cur_arg_))
-        str_args_.MakeMulti(cur_arg_);
+ArgParser& ArgParser::MultiValue(const uint min_count, const uint max_count) {
+    if (cur_type_ == ArgumentType::kInt) {
+        int_args_.MakeMulti(cur_id_);
+        int_args_.SetValuesCount(cur_id_, min_count, max_count);
+    } else if (cur_type_ == ArgumentType::kString) {
+        str_args_.MakeMulti(cur_id_);
+        str_args_.SetValuesCount(cur_id_, min_count, max_count);
+    } else if (cur_type_ == ArgumentType::kFlag) {
+        flags_.MakeMulti(cur_id_);
+    }
     return *this;
 }
 
 ArgParser& ArgParser::StoreValues(std::vector<std::string>& values) {
-    str_args_.PutValues(cur_arg_, &values);
+    if (cur_type_ == ArgumentType::kString) {
+        str_args_.PutValues(cur_id_, &values);
+        MakeOptional();
+    } else {
+        PrintError("Try store string values of non-string argument", GetCurrentName());
+    }
     return *this;
 }
 
 ArgParser& ArgParser::Positional() {
-    // std::cerr << cur_arg_ << '\n';
-    if (IsStringArgument(str_args_, cur_arg_)) {
-        // str_args_.MakeMulti(cur_arg_);
-        str_args_.PutPositional(cur_arg_);
-    } else if (IsIntArgument(int_args_, cur_arg_)) {
-        // int_args_.MakeMulti(cur_arg_);
-        int_args_.PutPositional(cur_arg_);
+    if (cur_type_ == ArgumentType::kString && str_args_.IsMap(cur_id_)) {
+        PrintError("Try make positional map argument", GetCurrentName());
+    } else if (cur_type_ == ArgumentType::kString) {
+        if (str_args_.IsPositional())
+            PrintWarning("Positional argument redefined from", str_args_.GetName(strings_, str_args_.GetPositional()));
+        str_args_.PutPositional(cur_id_);
+    } else if (cur_type_ == ArgumentType::kInt) {
+        int_args_.PutPositional(cur_id_);
     } else {
-        PrintError("Try make positional flag argument", cur_arg_);
+        PrintError("Try make positional flag argument", GetCurrentName());
     }
 
     return *this;
 }
 
 std::string& ArgParser::GetStringValue(const char* name) {
-    return *str_args_.GetValue(name);
+    const size_t id = str_args_.Find(strings_, name);
+    if (id == kNoArgument || !str_args_.IsStored(id)) {
+        PrintError("No such argument in parser:", name);
+        exit(EXIT_FAILURE);
+    }
+    return str_args_.GetValue(id);
+}
+
+const StringMap& ArgParser::GetMap(const std::string& name) {
+    const size_t id = str_args_.Find(strings_, name);
+    if (id == kNoArgument || !str_args_.IsMap(id)) {
+        PrintError("No such map argument in parser:", name);
+        exit(EXIT_FAILURE);
+    }
+    return str_args_.GetMap(id);
+}
+
+const IntRangeSet& ArgParser::GetRangeSet(const std::string& name) {
+    const size_t id = str_args_.Find(strings_, name);
+    if (id == kNoArgument || !str_args_.IsRangeSet(id)) {
+        PrintError("No such range argument in parser:", name);
+        exit(EXIT_FAILURE);
+    }
+    return str_args_.GetRangeSet(id);
 }
 
 int& ArgParser::GetIntValue(const std::string& name) {
-    return *int_args_.GetValue(name);
+    const size_t id = int_args_.Find(strings_, name);
+    if (id == kNoArgument || !int_args_.IsStored(id)) {
+        PrintError("No such argument in parser:", name);
+        exit(EXIT_FAILURE);
+    }
+    return int_args_.GetValue(id);
 }
 
 bool& ArgParser::GetFlag(const std::string& name) {
-    return *flags_.GetValue(name);
+    const size_t id = flags_.Find(strings_, name);
+    if (id == kNoArgument || !flags_.IsStored(id)) {
+        PrintError("No such argument in parser:", name);
+        exit(EXIT_FAILURE);
+    }
+    return flags_.GetValue(id);
+}
+
+ArgParser& ArgParser::Handle(ArgHandle<int>& handle) {
+    if (cur_type_ != ArgumentType::kInt) {
+        PrintError("Try get int handle of non-int argument", GetCurrentName());
+    } else if (int_args_.IsMultiValueArgument(cur_id_) != ArgHandle<int>::kIsMulti) {
+        PrintError("Try get single value handle of MultiValue argument", GetCurrentName());
+    } else {
+        handle.id_ = cur_id_;
+    }
+    return *this;
+}
+
+ArgParser& ArgParser::Handle(ArgHandle<std::vector<int>>& handle) {
+    if (cur_type_ != ArgumentType::kInt) {
+        PrintError("Try get int values handle of non-int argument", GetCurrentName());
+    } else if (int_args_.IsMultiValueArgument(cur_id_) != ArgHandle<std::vector<int>>::kIsMulti) {
+        PrintError("Try get values handle of single value argument", GetCurrentName());
+    } else {
+        handle.id_ = cur_id_;
+    }
+    return *this;
+}
+
+ArgParser& ArgParser::Handle(ArgHandle<std::string>& handle) {
+    if (cur_type_ != ArgumentType::kString) {
+        PrintError("Try get string handle of non-string argument", GetCurrentName());
+    } else if (str_args_.IsMultiValueArgument(cur_id_) != ArgHandle<std::string>::kIsMulti) {
+        PrintError("Try get single value handle of MultiValue argument", GetCurrentName());
+    } else {
+        handle.id_ = cur_id_;
+    }
+    return *this;
+}
+
+ArgParser& ArgParser::Handle(ArgHandle<std::vector<std::string>>& handle) {
+    if (cur_type_ != ArgumentType::kString) {
+        PrintError("Try get string values handle of non-string argument", GetCurrentName());
+    } else if (str_args_.IsMultiValueArgument(cur_id_) != ArgHandle<std::vector<std::string>>::kIsMulti) {
+        PrintError("Try get values handle of single value argument", GetCurrentName());
+    } else {
+        handle.id_ = cur_id_;
+    }
+    return *this;
+}
+
+ArgParser& ArgParser::Handle(ArgHandle<bool>& handle) {
+    if (cur_type_ == ArgumentType::kFlag) {
+        handle.id_ = cur_id_;
+    } else {
+        PrintError("Try get flag handle of non-flag argument", GetCurrentName());
+    }
+    return *this;
+}
+
+int& ArgParser::Get(const ArgHandle<int> handle) {
+    CheckHandle(handle);
+    return int_args_.GetValue(handle.id_);
+}
+
+std::vector<int>& ArgParser::Get(const ArgHandle<std::vector<int>> handle) {
+    CheckHandle(handle);
+    return int_args_.GetValues(handle.id_);
+}
+
+std::string& ArgParser::Get(const ArgHandle<std::string> handle) {
+    CheckHandle(handle);
+    return str_args_.GetValue(handle.id_);
+}
+
+std::vector<std::string>& ArgParser::Get(const ArgHandle<std::vector<std::string>> handle) {
+    CheckHandle(handle);
+    return str_args_.GetValues(handle.id_);
+}
+
+bool& ArgParser::Get(const ArgHandle<bool> handle) {
+    CheckHandle(handle);
+    return flags_.GetValue(handle.id_);
 }
 
 ArgParser& ArgParser::AddIntArgument(const std::string& key,
                                      const std::string& name,
                                      const std::string& desc) {
-    cur_arg_ = name;
-    int_args_.SetArgument(key, name, desc);
+    const size_t size = int_args_.Size();
+    cur_type_ = ArgumentType::kInt;
+    cur_id_ = int_args_.SetArgument(strings_, key, name, desc);
+    RegisterArgument(int_args_, size);
     return *this;
 }
 
@@ -374,79 +1741,163 @@ ArgParser& ArgParser::AddIntArgument(const std::string& name,
 }
 
 ArgParser& ArgParser::StoreValue(int& value) {
-    int_args_.PutValue(cur_arg_, &value);
+    if (cur_type_ == ArgumentType::kInt) {
+        int_args_.PutValue(cur_id_, &value);
+        MakeOptional();
+    } else {
+        PrintError("Try store int value of non-int argument", GetCurrentName());
+    }
     return *this;
 }
 
 ArgParser& ArgParser::StoreValues(std::vector<int>& values) {
-    int_args_.PutValues(cur_arg_, &values);
+    if (cur_type_ == ArgumentType::kInt) {
+        int_args_.PutValues(cur_id_, &values);
+        MakeOptional();
+    } else {
+        PrintError("Try store int values of non-int argument", GetCurrentName());
+    }
     return *this;
 }
 
-ArgParser::~ArgParser() = default;
+ArgParser::~ArgParser() {
+    WaitPathChecks();
+}
+
+size_t BaseArgumentConfig::Find(const StringPool& pool, const std::string_view str) const {
+    const uint32_t id = index_.Find(pool, str);
+    return id == NameIndex::kNone ? kNoArgument : id;
+}
+
+std::string_view BaseArgumentConfig::GetName(const StringPool& pool, const size_t id) const {
+    return pool.View(names_[id]);
+}
+
+std::string_view BaseArgumentConfig::GetDescription(const StringPool& pool, const size_t id) const {
+    return pool.View(descs_[id]);
+}
+
+size_t BaseArgumentConfig::Size() const {
+    return names_.size();
+}
+
+size_t BaseArgumentConfig::GetBit(const size_t id) const {
+    return bits_[id];
+}
+
+void BaseArgumentConfig::SetBit(const size_t id, const size_t bit) {
+    bits_[id] = static_cast<uint32_t>(bit);
+}
 
-std::string BaseArgumentConfig::GetByKey(const std::string& key) const {
-    if (!keys_.contains(key)) {
-        PrintError("Can't find key argument", key);
+// Adding a name twice returns the first id, as the map based config kept the first definition
+size_t BaseArgumentConfig::AddArgument(StringPool& pool,
+                                       const std::string_view key,
+                                       const std::string_view name,
+                                       const std::string_view desc) {
+    if (const size_t id = Find(pool, name) ; id != kNoArgument && GetName(pool, id) == name) {
+        if (!key.empty() && key != name)
+            index_.Insert(pool, pool.Add(key), static_cast<uint32_t>(id));
+        return id;
     }
-    return keys_.at(key);
+
+    const size_t id = names_.size();
+    names_.push_back(pool.Add(name));
+    keys_.push_back(pool.Add(key));
+    descs_.push_back(pool.Add(desc));
+    properties_.push_back(0);
+    bits_.push_back(0);
+    min_count_.push_back(0);
+    max_count_.push_back(std::numeric_limits<uint32_t>::max());
+    values_count_.push_back(0);
+    index_.Insert(pool, names_[id], static_cast<uint32_t>(id));
+    if (!key.empty() && key != name)
+        index_.Insert(pool, keys_[id], static_cast<uint32_t>(id));
+
+    return id;
 }
 
-std::string BaseArgumentConfig::GetDescription(const std::string& name) const {
-    if (!used_.contains(name))
-        PrintError("Can't find argument", name);
-    return used_.at(name).desc_;
+void BaseArgumentConfig::MakeMulti(const size_t id) {
+    properties_[id] |= kMulti;
 }
 
-bool BaseArgumentConfig::KeyContains(const std::string& key) const {
-    return keys_.contains(key);
+bool BaseArgumentConfig::IsMultiValueArgument(const size_t id) const {
+    return properties_[id] & kMulti;
 }
 
-void BaseArgumentConfig::SetArgument(const std::string& key,
-                                     const std::string& name,
-                                     const std::string& desc) {
-    used_.insert({name, ArgumentMainData{key, desc}});
-    keys_.insert({key, name});
+bool BaseArgumentConfig::IsDefault(const size_t id) const {
+    return properties_[id] & kDefault;
+}
+
+void BaseArgumentConfig::SetLazyDefault(const size_t id) {
+    properties_[id] |= kLazyDefault;
 }
 
-void BaseArgumentConfig::MakeMulti(const std::string& arg) {
-    is_multi_.insert(arg);
+bool BaseArgumentConfig::IsStored(const size_t id) const {
+    return properties_[id] & kStored;
 }
 
-bool BaseArgumentConfig::IsMultiValueArgument(const std::string& arg) const {
-    return is_multi_.contains(arg);
+void BaseArgumentConfig::SetValuesCount(const size_t id, const size_t min_count, const size_t max_count) {
+    min_count_[id] = static_cast<uint32_t>(min_count);
+    max_count_[id] = static_cast<uint32_t>(max_count);
 }
 
-std::vector<std::string> BaseArgumentConfig::GetUsedArgumentsList() const {
-    std::vector<std::string> keys;
-    keys.reserve(used_.size());
-    for (const auto& [key, _]: used_)
-        keys.push_back(key);
-    return keys;
+size_t BaseArgumentConfig::GetValuesLeft(const size_t id) const {
+    if (max_count_[id] == std::numeric_limits<uint32_t>::max())
+        return std::numeric_limits<size_t>::max();
+
+    return max_count_[id] > values_count_[id] ? max_count_[id] - values_count_[id] : 0;
+}
+
+bool BaseArgumentConfig::HasEnoughValues(const size_t id) const {
+    return (properties_[id] & (kDefault | kLazyDefault)) || values_count_[id] >= min_count_[id];
 }
 
-bool BaseArgumentConfig::IsDefault(const std::string& arg) const {
-    return is_default_.contains(arg);
+void BaseArgumentConfig::ResetValuesCount() {
+    std::ranges::fill(values_count_, 0);
 }
 
-std::vector<std::string> BaseArgumentConfig::GetKeyArgumentsList() const {
-    std::vector<std::string> res;
-    res.reserve(keys_.size());
-    for (auto& [key, _]: keys_) {
-        res.push_back(key);
+void BaseArgumentConfig::ResetValues() {
+    for (auto& properties: properties_) {
+        properties &= kDefault | kMulti | kBound | kLazyDefault;
+        if (properties & (kDefault | kBound))
+            properties |= kStored;
     }
-    return res;
+    ResetValuesCount();
+}
+
+void BaseArgumentConfig::CountValues(const size_t id, const size_t count) {
+    values_count_[id] += count;
+}
+
+// The first value of a parse reserves room for every remaining token, capped by the maximal count
+size_t BaseArgumentConfig::GetReservation(const size_t id, const size_t remaining) const {
+    if (!IsMultiValueArgument(id) || values_count_[id] != 0)
+        return 0;
+
+    return std::min(remaining, GetValuesLeft(id));
 }
 
-std::string BaseArgumentConfig::GetArgumentHelpDescription(const char* type, const std::string& arg) const {
+std::vector<size_t> BaseArgumentConfig::GetSortedArguments(const StringPool& pool) const {
+    std::vector<size_t> ids(names_.size());
+    for (size_t id = 0 ; id < ids.size() ; ++id)
+        ids[id] = id;
+    std::ranges::sort(ids, {}, [&](const size_t id) { return GetName(pool, id); });
+    return ids;
+}
+
+std::string BaseArgumentConfig::GetArgumentHelpDescription(const StringPool& pool,
+                                                           const std::string_view type,
+                                                           const size_t id) const {
     std::stringstream out;
-    auto& [key, desc] = used_.at(arg);
+    const std::string_view key = pool.View(keys_[id]);
+    const std::string_view arg = GetName(pool, id);
+    const std::string_view desc = GetDescription(pool, id);
 
     out << key;
     if (!key.empty()) out << ", ";
     else out << "    ";
     out << arg;
-    if (std::strcmp(type, "flag") != 0) out << "=<" << type << ">";
+    if (type != "flag") out << "=<" << type << ">";
     out << ",";
     if (!desc.empty()) out << " ";
     if (arg != "--help") out << desc;
@@ -455,103 +1906,306 @@ std::string BaseArgumentConfig::GetArgumentHelpDescription(const char* type, con
     return out.str();
 }
 
-void StringArgumentConfig::PutValue(const std::string& name, std::string* value) {
-    names_.insert({name, value});
+void BaseArgumentConfig::AddMemoryFootprint(MemoryFootprintReport& report) const {
+    report.arguments += (names_.capacity() + keys_.capacity() + descs_.capacity()) * sizeof(StringPool::Ref)
+            + properties_.capacity() * sizeof(uint8_t)
+            + bits_.capacity() * sizeof(uint32_t)
+            + (min_count_.capacity() + max_count_.capacity() + values_count_.capacity()) * sizeof(uint32_t);
+    report.index += index_.MemoryFootprint();
+}
+
+size_t StringArgumentConfig::SetArgument(StringPool& pool,
+                                         const std::string_view key,
+                                         const std::string_view name,
+                                         const std::string_view desc) {
+    const size_t id = AddArgument(pool, key, name, desc);
+    if (id == value_.size()) {
+        value_.push_back(&cvalue_.emplace_back());
+        values_.push_back(&cvalues_.emplace_back());
+        validator_.push_back(NameIndex::kNone);
+        map_.push_back(NameIndex::kNone);
+        range_set_.push_back(NameIndex::kNone);
+        actions_.emplace_back();
+    }
+    return id;
+}
+
+StringArgumentConfig::StringArgumentConfig(const StringArgumentConfig& other)
+    : BaseArgumentConfig(other),
+      cvalue_(other.cvalue_),
+      cvalues_(other.cvalues_),
+      validator_(other.validator_),
+      validators_(other.validators_),
+      map_(other.map_),
+      maps_(other.maps_),
+      range_set_(other.range_set_),
+      range_sets_(other.range_sets_),
+      actions_(other.actions_.size()),
+      positional_(other.positional_) {
+    for (size_t id = 0 ; id < cvalue_.size() ; ++id) {
+        value_.push_back(&cvalue_[id]);
+        values_.push_back(&cvalues_[id]);
+    }
 }
 
-bool BaseArgumentConfig::Contains(const std::string& name) const {
-    return used_.contains(name);
+// A default set before binding is copied into the bound variable
+void StringArgumentConfig::PutValue(const size_t id, std::string* value) {
+    if (IsDefault(id))
+        *value = cvalue_[id];
+    value_[id] = value;
+    properties_[id] |= kStored | kBound;
 }
 
-std::string*& StringArgumentConfig::GetValue(const std::string& name) {
-    if (!names_.contains(name)) {
-        PrintError("No such argument in parser:", name);
-        exit(EXIT_FAILURE);
-    }
-    return names_.at(name);
+std::string& StringArgumentConfig::GetValue(const size_t id) {
+    return *value_[id];
 }
 
-void StringArgumentConfig::PutValues(const std::string& name,
-                                     std::vector<std::string>* values) {
-    multi_.insert({name, values});
+void StringArgumentConfig::PutValues(const size_t id, std::vector<std::string>* values) {
+    values_[id] = values;
+    properties_[id] |= kStored | kBound;
 }
 
-void StringArgumentConfig::PutPositional(const std::string& arg) {
-    if (!positional_.empty())
-        PrintWarning("Positional argument redefined from", positional_);
-    positional_ = arg;
-    is_positional = true;
+void StringArgumentConfig::PutPositional(const size_t id) {
+    positional_ = id;
 }
 
-std::string StringArgumentConfig::GetPositional() const {
+size_t StringArgumentConfig::GetPositional() const {
     return positional_;
 }
 
 bool StringArgumentConfig::IsPositional() const {
-    return is_positional;
+    return positional_ != kNoArgument;
+}
+
+void StringArgumentConfig::SetDefault(const size_t id, const std::string& value) {
+    cvalue_[id] = value;
+    *value_[id] = value;
+    properties_[id] |= kDefault | kStored;
+}
+
+void StringArgumentConfig::SetParcedArgument(const size_t id, const std::string_view value) {
+    if (map_[id] != NameIndex::kNone) {
+        // IsValid has checked the separator and the duplicate policy
+        const size_t eq = value.find('=');
+        this->CountValues(id, 1);
+        maps_[map_[id]].map_.Insert(value.substr(0, eq), value.substr(eq + 1), true);
+    } else if (range_set_[id] != NameIndex::kNone) {
+        static_cast<void>(SetParcedRanges(id, value));
+        return;
+    } else if (this->IsMultiValueArgument(id)) {
+        this->CountValues(id, 1);
+        values_[id]->emplace_back(value);
+    } else {
+        value_[id]->assign(value);
+    }
+    properties_[id] |= kStored;
+
+    if (actions_[id])
+        actions_[id](value);
+}
+
+bool StringArgumentConfig::SetParcedRanges(const size_t id, const std::string_view value) {
+    if (!range_sets_[range_set_[id]].Add(value))
+        return false;
+
+    this->CountValues(id, 1);
+    properties_[id] |= kStored;
+    if (actions_[id])
+        actions_[id](value);
+    return true;
+}
+
+void StringArgumentConfig::SetParcedArguments(const size_t id, std::span<std::string> values) {
+    // Single values are overwritten, map pairs and range expressions are not kept as strings
+    if (!this->IsMultiValueArgument(id) || map_[id] != NameIndex::kNone || range_set_[id] != NameIndex::kNone) {
+        if (map_[id] != NameIndex::kNone)
+            maps_[map_[id]].map_.Reserve(values.size());
+        for (const auto& value: values)
+            this->SetParcedArgument(id, value);
+        return;
+    }
+
+    this->CountValues(id, values.size());
+    auto* target = values_[id];
+    target->reserve(target->size() + values.size());
+    properties_[id] |= kStored;
+
+    if (!actions_[id]) {
+        std::ranges::move(values, std::back_inserter(*target));
+        return;
+    }
+
+    // The action runs right after each value is stored, in order, as in sequential parsing
+    for (auto& value: values) {
+        target->push_back(std::move(value));
+        actions_[id](target->back());
+    }
 }
 
-void StringArgumentConfig::CreateValue(const std::string& name, const std::string& value) {
-    cvalue_.insert({name, value});
-    names_.insert({name, &cvalue_.at(name)});
+void StringArgumentConfig::SetParcedValues(const size_t id, const size_t begin) {
+    auto& values = *values_[id];
+    this->CountValues(id, values.size() - begin);
+    properties_[id] |= kStored;
+
+    if (actions_[id]) {
+        for (size_t i = begin ; i < values.size() ; ++i)
+            actions_[id](values[i]);
+    }
+}
+
+void StringArgumentConfig::ResetValues() {
+    BaseArgumentConfig::ResetValues();
+    for (auto& values: cvalues_)
+        values.clear();
+    for (auto& map: maps_)
+        map.map_.Clear();
+    for (auto& range_set: range_sets_)
+        range_set.Clear();
 }
 
-void StringArgumentConfig::CreateValues(const std::string& name) {
-    cvalues_.insert({name, {}});
-    multi_.insert({name, &cvalues_.at(name)});
+void StringArgumentConfig::ReserveValues(const size_t id, const size_t remaining) {
+    const size_t reservation = this->GetReservation(id, remaining);
+    if (reservation == 0)
+        return;
+
+    // Maps grow with the pairs actually inserted, a parallel run reserves for its own pairs
+    if (map_[id] != NameIndex::kNone || range_set_[id] != NameIndex::kNone)
+        return;
+
+    values_[id]->reserve(values_[id]->size() + reservation);
+    properties_[id] |= kStored;
 }
 
-void StringArgumentConfig::AddValue(const std::string& arg, const std::string& value) {
-    if (!multi_.contains(arg)) {
-        PrintError("Can't set multi value argument:", arg);
+StringArgumentConfig::StringValidator& StringArgumentConfig::GetValidator(const size_t id) {
+    if (validator_[id] == NameIndex::kNone) {
+        validator_[id] = static_cast<uint32_t>(validators_.size());
+        validators_.emplace_back();
     }
-    cvalues_.at(arg).push_back(value);
+    return validators_[validator_[id]];
 }
 
-bool StringArgumentConfig::IsStored(const std::string& arg) const {
-    return names_.contains(arg) || multi_.contains(arg);
+void StringArgumentConfig::SetChoices(const size_t id, const std::initializer_list<std::string_view> choices) {
+    auto& set = GetValidator(id).choices_;
+    set.reserve(choices.size());
+    for (auto choice: choices) {
+        set.emplace(choice);
+    }
 }
 
-void StringArgumentConfig::SetDefault(const std::string& arg, const std::string& value) {
-    this->CreateValue(arg, value);
-    is_default_.insert(arg);
+void StringArgumentConfig::SetPattern(const size_t id, const std::string& pattern) {
+    GetValidator(id).pattern_ = std::make_shared<const std::regex>(pattern, std::regex::optimize);
 }
 
-void StringArgumentConfig::SetParcedArgument(const std::string& arg, const std::string& value) {
-    if (this->IsMultiValueArgument(arg)) {
-        if (this->IsStored(arg)) {
-            this->GetValues(arg)->push_back(value);
-        } else {
-            if (!multi_.contains(arg)) {
-                this->CreateValues(arg);
-            }
-            this->AddValue(arg, value);
-        }
-    } else {
-        if (this->IsStored(arg)) {
-            *this->GetValue(arg) = value;
-        } else {
-            this->CreateValue(arg, value);
-        }
+void StringArgumentConfig::SetUtf8(const size_t id) {
+    GetValidator(id).is_utf8_ = true;
+}
+
+void StringArgumentConfig::MakePath(const size_t id) {
+    GetValidator(id).is_path_ = true;
+}
+
+void StringArgumentConfig::AddPathChecks(const size_t id, const uint8_t checks) {
+    GetValidator(id).path_checks_ |= checks;
+}
+
+bool StringArgumentConfig::IsPath(const size_t id) const {
+    return validator_[id] != NameIndex::kNone && validators_[validator_[id]].is_path_;
+}
+
+uint8_t StringArgumentConfig::GetPathChecks(const size_t id) const {
+    return validator_[id] != NameIndex::kNone ? validators_[validator_[id]].path_checks_ : 0;
+}
+
+void StringArgumentConfig::SetGlob(const size_t id) {
+    GetValidator(id).is_glob_ = true;
+}
+
+bool StringArgumentConfig::IsGlob(const size_t id) const {
+    return validator_[id] != NameIndex::kNone && validators_[validator_[id]].is_glob_;
+}
+
+void StringArgumentConfig::MakeMap(const size_t id) {
+    if (map_[id] != NameIndex::kNone)
+        return;
+    map_[id] = static_cast<uint32_t>(maps_.size());
+    maps_.emplace_back();
+    MakeMulti(id);
+}
+
+void StringArgumentConfig::SetUniqueKeys(const size_t id) {
+    maps_[map_[id]].is_unique_keys_ = true;
+}
+
+bool StringArgumentConfig::IsMap(const size_t id) const {
+    return map_[id] != NameIndex::kNone;
+}
+
+const StringMap& StringArgumentConfig::GetMap(const size_t id) const {
+    return maps_[map_[id]].map_;
+}
+
+void StringArgumentConfig::MakeRangeSet(const size_t id) {
+    if (range_set_[id] != NameIndex::kNone)
+        return;
+    range_set_[id] = static_cast<uint32_t>(range_sets_.size());
+    range_sets_.emplace_back();
+    MakeMulti(id);
+}
+
+bool StringArgumentConfig::IsRangeSet(const size_t id) const {
+    return range_set_[id] != NameIndex::kNone;
+}
+
+const IntRangeSet& StringArgumentConfig::GetRangeSet(const size_t id) const {
+    return range_sets_[range_set_[id]];
+}
+
+void StringArgumentConfig::SetAction(const size_t id, Action action) {
+    actions_[id] = std::move(action);
+}
+
+bool StringArgumentConfig::IsValid(const size_t id, const std::string_view value) const {
+    if (map_[id] != NameIndex::kNone) {
+        const size_t eq = value.find('=');
+        if (eq == 0 || eq == std::string_view::npos)
+            return false;
+        if (const auto& map = maps_[map_[id]] ; map.is_unique_keys_ && map.map_.Contains(value.substr(0, eq)))
+            return false;
     }
+
+    if (validator_[id] == NameIndex::kNone)
+        return true;
+
+    const auto& validator = validators_[validator_[id]];
+    if (validator.is_utf8_ && !IsValidUtf8(value))
+        return false;
+
+    if (!validator.choices_.empty() && !validator.choices_.contains(value))
+        return false;
+
+    if (validator.pattern_ != nullptr && !std::regex_match(value.begin(), value.end(), *validator.pattern_))
+        return false;
+
+    return true;
 }
-std::string StringArgumentConfig::GetExtraArgumentsDescription(const std::string& arg) const {
+
+std::string StringArgumentConfig::GetExtraArgumentsDescription(const size_t id) const {
     std::stringstream out;
     bool any = false;
-    if (is_multi_.contains(arg)) {
+    if (IsMultiValueArgument(id)) {
         out << "repeated";
         any = true;
     }
 
-    if (is_default_.contains(arg)) {
+    if (IsDefault(id)) {
         if (any) out << ", ";
         out << "default = ";
-        if (any) out << cvalues_.at(arg);
-        else out << cvalue_.at(arg);
+        if (any) out << cvalues_[id];
+        else out << cvalue_[id];
         any = true;
     }
 
-    if (positional_ == arg) {
+    if (positional_ == id) {
         if (any) out << ", ";
         out << "positional";
         any = true;
@@ -562,107 +2216,185 @@ std::string StringArgumentConfig::GetExtraArgumentsDescription(const std::string
     return " [" + out.str() + "]";
 }
 
-// void StringArgumentConfig::CreateValues(std::string name, const std::string& value) {
-//     if (!cvalues_.contains(name)) {
-//         cvalues_.insert({name, {}});
-//     }
-//     cvalues_[name].push_back(value);
-//     multi_.insert({name, })
-// }
-
-std::vector<std::string>*&
-StringArgumentConfig::GetValues(const std::string& name) {
-    return multi_.at(name);
+std::vector<std::string>& StringArgumentConfig::GetValues(const size_t id) {
+    return *values_[id];
+}
+
+void StringArgumentConfig::AddMemoryFootprint(MemoryFootprintReport& report) const {
+    BaseArgumentConfig::AddMemoryFootprint(report);
+    report.arguments += value_.capacity() * sizeof(std::string*)
+            + values_.capacity() * sizeof(std::vector<std::string>*)
+            + validator_.capacity() * sizeof(uint32_t)
+            + validators_.capacity() * sizeof(StringValidator)
+            + map_.capacity() * sizeof(uint32_t)
+            + range_set_.capacity() * sizeof(uint32_t)
+            + actions_.capacity() * sizeof(Action);
+    report.values += cvalue_.size() * sizeof(std::string) + cvalues_.size() * sizeof(std::vector<std::string>);
+    for (const auto& values: cvalues_)
+        report.values += values.capacity() * sizeof(std::string);
+    for (const auto& map: maps_)
+        report.values += sizeof(KeyValueMap) + map.map_.MemoryFootprint();
+    for (const auto& range_set: range_sets_)
+        report.values += sizeof(IntRangeSet) + range_set.MemoryFootprint();
+}
+
+size_t IntArgumentConfig::SetArgument(StringPool& pool,
+                                      const std::string_view key,
+                                      const std::string_view name,
+                                      const std::string_view desc) {
+    const size_t id = AddArgument(pool, key, name, desc);
+    if (id == value_.size()) {
+        value_.push_back(&cvalue_.emplace_back());
+        values_.push_back(&cvalues_.emplace_back());
+        validator_.push_back(NameIndex::kNone);
+        actions_.emplace_back();
+    }
+    return id;
+}
+
+IntArgumentConfig::IntArgumentConfig(const IntArgumentConfig& other)
+    : BaseArgumentConfig(other),
+      cvalue_(other.cvalue_),
+      cvalues_(other.cvalues_),
+      validator_(other.validator_),
+      validators_(other.validators_),
+      actions_(other.actions_.size()),
+      positional_(other.positional_) {
+    for (size_t id = 0 ; id < cvalue_.size() ; ++id) {
+        value_.push_back(&cvalue_[id]);
+        values_.push_back(&cvalues_[id]);
+    }
 }
 
-void IntArgumentConfig::PutValue(const std::string& name, int* value) {
-    names_.insert({name, value});
+// A default set before binding is copied into the bound variable
+void IntArgumentConfig::PutValue(const size_t id, int* value) {
+    if (IsDefault(id))
+        *value = cvalue_[id];
+    value_[id] = value;
+    properties_[id] |= kStored | kBound;
 }
 
-void IntArgumentConfig::PutValues(const std::string& name,
-                                  std::vector<int>* values) {
-    multi_.insert({name, values});
+void IntArgumentConfig::PutValues(const size_t id, std::vector<int>* values) {
+    values_[id] = values;
+    properties_[id] |= kStored | kBound;
 }
-void IntArgumentConfig::PutPositional(const std::string& arg) {
-    positional_ = arg;
-    is_positional_ = true;
+void IntArgumentConfig::PutPositional(const size_t id) {
+    positional_ = id;
 }
 
-int*& IntArgumentConfig::GetValue(const std::string& name) {
-    if (!names_.contains(name)) {
-        PrintError("No such argument in parser:", name);
-        exit(EXIT_FAILURE);
-    }
-    return names_.at(name);
+int& IntArgumentConfig::GetValue(const size_t id) {
+    return *value_[id];
 }
-std::vector<int>*& IntArgumentConfig::GetValues(const std::string& name) {
-    return multi_.at(name);
+std::vector<int>& IntArgumentConfig::GetValues(const size_t id) {
+    return *values_[id];
 }
-std::string IntArgumentConfig::GetPositional() const {
+size_t IntArgumentConfig::GetPositional() const {
     return positional_;
 }
 bool IntArgumentConfig::IsPositional() const {
-    return is_positional_;
+    return positional_ != kNoArgument;
 }
-void IntArgumentConfig::CreateValue(const std::string& name, const int value) {
-    cvalue_.insert({name, value});
-    names_.insert({name, &cvalue_[name]});
+
+void IntArgumentConfig::SetDefault(const size_t id, const int value) {
+    cvalue_[id] = value;
+    *value_[id] = value;
+    properties_[id] |= kDefault | kStored;
 }
-void IntArgumentConfig::CreateValues(const std::string& name) {
-    cvalues_.insert({name, {}});
-    multi_.insert({name, &cvalues_[name]});
+
+void IntArgumentConfig::SetParcedArgument(const size_t id, const int value) {
+    if (this->IsMultiValueArgument(id)) {
+        this->CountValues(id, 1);
+        values_[id]->push_back(value);
+    } else {
+        *value_[id] = value;
+    }
+    properties_[id] |= kStored;
+
+    if (actions_[id])
+        actions_[id](value);
 }
-void IntArgumentConfig::AddValue(const std::string& name, const int value) {
-    if (!cvalues_.contains(name)) {
-        PrintError("Can't set multi value argument:", name);
+void IntArgumentConfig::SetParcedArguments(const size_t id, std::span<const int> values) {
+    // The action runs right after each value is stored, in order, as in sequential parsing
+    if (!this->IsMultiValueArgument(id) || actions_[id]) {
+        for (const int value: values)
+            this->SetParcedArgument(id, value);
+        return;
     }
-    cvalues_[name].push_back(value);
+
+    this->CountValues(id, values.size());
+    auto* target = values_[id];
+    target->insert(target->end(), values.begin(), values.end());
+    properties_[id] |= kStored;
 }
 
-bool IntArgumentConfig::IsStored(const std::string& arg) const {
-    return names_.contains(arg) || multi_.contains(arg);
+void IntArgumentConfig::ResetValues() {
+    BaseArgumentConfig::ResetValues();
+    for (auto& values: cvalues_)
+        values.clear();
 }
 
-void IntArgumentConfig::SetDefault(const std::string& arg, const int value) {
-    this->CreateValue(arg, value);
-    is_default_.insert(arg);
+void IntArgumentConfig::ReserveValues(const size_t id, const size_t remaining) {
+    const size_t reservation = this->GetReservation(id, remaining);
+    if (reservation == 0)
+        return;
+
+    values_[id]->reserve(values_[id]->size() + reservation);
+    properties_[id] |= kStored;
 }
 
-void IntArgumentConfig::SetParcedArgument(const std::string& arg, const int value) {
-    if (this->IsMultiValueArgument(arg)) {
-        if (this->IsStored(arg)) {
-            this->GetValues(arg)->push_back(value);
-        } else {
-            if (!multi_.contains(arg)) {
-                this->CreateValues(arg);
-            }
-            this->AddValue(arg, value);
-        }
-    } else {
-        if (this->IsStored(arg)) {
-            *this->GetValue(arg) = value;
-        } else {
-            this->CreateValue(arg, value);
-        }
+IntArgumentConfig::IntValidator& IntArgumentConfig::GetValidator(const size_t id) {
+    if (validator_[id] == NameIndex::kNone) {
+        validator_[id] = static_cast<uint32_t>(validators_.size());
+        validators_.emplace_back();
     }
+    return validators_[validator_[id]];
+}
+
+void IntArgumentConfig::SetRange(const size_t id, const int min, const int max) {
+    auto& validator = GetValidator(id);
+    validator.min_ = min;
+    validator.max_ = max;
+}
+
+void IntArgumentConfig::SetChoices(const size_t id, const std::initializer_list<int> choices) {
+    GetValidator(id).choices_.insert(choices);
+}
+
+void IntArgumentConfig::SetAction(const size_t id, Action action) {
+    actions_[id] = std::move(action);
+}
+
+bool IntArgumentConfig::IsValid(const size_t id, const int value) const {
+    if (validator_[id] == NameIndex::kNone)
+        return true;
+
+    const auto& validator = validators_[validator_[id]];
+    if (value < validator.min_ || value > validator.max_)
+        return false;
+
+    if (!validator.choices_.empty() && !validator.choices_.contains(value))
+        return false;
+
+    return true;
 }
-std::string IntArgumentConfig::GetExtraArgumentsDescription(const std::string& arg) const {
+
+std::string IntArgumentConfig::GetExtraArgumentsDescription(const size_t id) const {
     std::stringstream out;
     bool any = false;
-    if (is_multi_.contains(arg)) {
+    if (IsMultiValueArgument(id)) {
         out << "repeated";
         any = true;
     }
 
-    if (is_default_.contains(arg)) {
+    if (IsDefault(id)) {
         if (any) out << ", ";
         out << "default = ";
-        if (any) out << cvalues_.at(arg);
-        else out << cvalue_.at(arg);
+        if (any) out << cvalues_[id];
+        else out << cvalue_[id];
         any = true;
     }
 
-    if (positional_ == arg) {
+    if (positional_ == id) {
         if (any) out << ", ";
         out << "positional";
         any = true;
@@ -673,50 +2405,208 @@ std::string IntArgumentConfig::GetExtraArgumentsDescription(const std::string& a
     return " [" + out.str() + "]";
 }
 
+void IntArgumentConfig::AddMemoryFootprint(MemoryFootprintReport& report) const {
+    BaseArgumentConfig::AddMemoryFootprint(report);
+    report.arguments += value_.capacity() * sizeof(int*)
+            + values_.capacity() * sizeof(std::vector<int>*)
+            + validator_.capacity() * sizeof(uint32_t)
+            + validators_.capacity() * sizeof(IntValidator)
+            + actions_.capacity() * sizeof(Action);
+    report.values += cvalue_.size() * sizeof(int) + cvalues_.size() * sizeof(std::vector<int>);
+    for (const auto& values: cvalues_)
+        report.values += values.capacity() * sizeof(int);
+}
+
+EnumArgumentConfig::EnumArgumentConfig(const EnumArgumentConfig& other)
+    : BaseArgumentConfig(other),
+      assign_(other.assign_),
+      name_of_(other.name_of_),
+      clone_(other.clone_),
+      choices_(other.choices_),
+      type_(other.type_),
+      actions_(other.actions_.size()) {
+    // The copy starts from the defaults, not from what the original parsed last
+    for (size_t id = 0 ; id < assign_.size() ; ++id) {
+        storage_.push_back(clone_[id] != nullptr ? clone_[id](other.default_[id].get()) : nullptr);
+        default_.push_back(clone_[id] != nullptr ? clone_[id](other.default_[id].get()) : nullptr);
+        value_.push_back(storage_.back().get());
+    }
+}
+
+size_t EnumArgumentConfig::SetArgument(StringPool& pool,
+                                       const std::string_view key,
+                                       const std::string_view name,
+                                       const std::string_view desc) {
+    const size_t id = AddArgument(pool, key, name, desc);
+    if (id == value_.size()) {
+        assign_.push_back(nullptr);
+        name_of_.push_back(nullptr);
+        clone_.push_back(nullptr);
+        choices_.emplace_back();
+        storage_.emplace_back();
+        default_.emplace_back();
+        value_.push_back(nullptr);
+        type_.push_back(nullptr);
+        actions_.emplace_back();
+    }
+    return id;
+}
+
+void EnumArgumentConfig::SetType(StringPool& pool,
+                                 const size_t id,
+                                 const Assign assign,
+                                 const NameOf name_of,
+                                 const Clone clone,
+                                 const std::string_view choices,
+                                 std::shared_ptr<void> storage,
+                                 const std::type_info& type) {
+    assign_[id] = assign;
+    name_of_[id] = name_of;
+    clone_[id] = clone;
+    choices_[id] = pool.Add(choices);
+    default_[id] = clone(storage.get());
+    storage_[id] = std::move(storage);
+    value_[id] = storage_[id].get();
+    type_[id] = &type;
+}
+
+void EnumArgumentConfig::PutValue(const size_t id, void* value, const std::type_info& type) {
+    if (*type_[id] != type) {
+        PrintError("Can't store enum argument in a variable of other type", "");
+        return;
+    }
+    value_[id] = value;
+    properties_[id] |= kStored | kBound;
+}
+
+void* EnumArgumentConfig::GetValue(const size_t id, const std::type_info& type) {
+    if (id >= type_.size() || *type_[id] != type) {
+        PrintError("No such enum argument in parser", "");
+        exit(EXIT_FAILURE);
+    }
+    return value_[id];
+}
+
+std::string_view EnumArgumentConfig::GetValueName(const size_t id) const {
+    return name_of_[id](value_[id]);
+}
+
+std::string_view EnumArgumentConfig::GetChoices(const StringPool& pool, const size_t id) const {
+    return pool.View(choices_[id]);
+}
+
+void* EnumArgumentConfig::GetDefault(const size_t id) {
+    return default_[id].get();
+}
+
+void EnumArgumentConfig::SetDefault(const size_t id) {
+    properties_[id] |= kDefault;
+}
+
+void EnumArgumentConfig::SetAction(const size_t id, Action action) {
+    actions_[id] = std::move(action);
+}
+
+bool EnumArgumentConfig::SetParcedArgument(const size_t id, const std::string_view name) {
+    if (!assign_[id](name, value_[id]))
+        return false;
+    properties_[id] |= kStored;
+
+    if (actions_[id])
+        actions_[id](name);
+    return true;
+}
+
+std::string EnumArgumentConfig::GetExtraArgumentsDescription(const size_t id) const {
+    if (!IsDefault(id))
+        return "";
+
+    return " [default = " + std::string(name_of_[id](default_[id].get())) + "]";
+}
+
+void EnumArgumentConfig::AddMemoryFootprint(MemoryFootprintReport& report) const {
+    BaseArgumentConfig::AddMemoryFootprint(report);
+    report.arguments += assign_.capacity() * sizeof(Assign)
+            + name_of_.capacity() * sizeof(NameOf)
+            + clone_.capacity() * sizeof(Clone)
+            + choices_.capacity() * sizeof(StringPool::Ref)
+            + storage_.capacity() * sizeof(std::shared_ptr<void>)
+            + default_.capacity() * sizeof(std::shared_ptr<void>)
+            + value_.capacity() * sizeof(void*)
+            + type_.capacity() * sizeof(const std::type_info*)
+            + actions_.capacity() * sizeof(Action);
+}
+
 bool ArgParser::Help() const {
     return is_added_help_;
 }
 
-void FlagConfig::PutValue(const std::string& name, bool* value) {
-    names_.insert({name, value});
-}
-void FlagConfig::MakeMulti(const std::string& basic_string) {
-    PrintWarning("try to make multivalue flag argument");
+FlagConfig::FlagConfig(const FlagConfig& other)
+    : BaseArgumentConfig(other),
+      cvalue_(other.cvalue_),
+      actions_(other.actions_.size()) {
+    for (auto& value: cvalue_)
+        value_.push_back(&value);
 }
 
-bool*& FlagConfig::GetValue(const std::string& name) {
-    if (!names_.contains(name)) {
-        PrintError("No such argument in parser:", name);
-        exit(EXIT_FAILURE);
+size_t FlagConfig::SetArgument(StringPool& pool,
+                               const std::string_view key,
+                               const std::string_view name,
+                               const std::string_view desc) {
+    const size_t id = AddArgument(pool, key, name, desc);
+    if (id == value_.size()) {
+        value_.push_back(&cvalue_.emplace_back(false));
+        actions_.emplace_back();
     }
-    return names_.at(name);
+    return id;
 }
-void FlagConfig::CreateValue(const std::string& arg) {
-    cvalue_.insert({arg, true});
-    names_.insert({arg, &cvalue_[arg]});
+
+// A default set before binding is copied into the bound variable
+void FlagConfig::PutValue(const size_t id, bool* value) {
+    if (IsDefault(id))
+        *value = cvalue_[id];
+    value_[id] = value;
+    properties_[id] |= kStored | kBound;
+}
+void FlagConfig::MakeMulti(size_t) {
+    PrintWarning("try to make multivalue flag argument");
+}
+
+bool& FlagConfig::GetValue(const size_t id) {
+    return *value_[id];
 }
-void FlagConfig::CreateValue(const std::string& arg, bool value) {
-    cvalue_.insert({arg, value});
-    names_.insert({arg, &cvalue_[arg]});
+void FlagConfig::SetParcedArgument(const size_t id) {
+    *value_[id] = true;
+    properties_[id] |= kStored;
+
+    if (actions_[id])
+        actions_[id]();
 }
-void FlagConfig::SetDefault(const std::string& arg, const bool value) {
-    CreateValue(arg, value);
-    is_default_.insert(arg);
+void FlagConfig::SetDefault(const size_t id, const bool value) {
+    cvalue_[id] = value;
+    *value_[id] = value;
+    properties_[id] |= kDefault | kStored;
 }
 
-bool FlagConfig::IsStored(const std::string& arg) const {
-    return names_.contains(arg);
+void FlagConfig::SetAction(const size_t id, Action action) {
+    actions_[id] = std::move(action);
 }
 
-std::string FlagConfig::GetExtraArgumentsDescription(const std::string& arg) const {
+std::string FlagConfig::GetExtraArgumentsDescription(const size_t id) const {
     std::stringstream out;
 
-    if (!is_default_.contains(arg)) {
+    if (!IsDefault(id)) {
         return "";
     }
 
-    out << " [default = " << (cvalue_.at(arg) ? "true]" : "false]");
+    out << " [default = " << (cvalue_[id] ? "true]" : "false]");
 
     return out.str();
 }
+
+void FlagConfig::AddMemoryFootprint(MemoryFootprintReport& report) const {
+    BaseArgumentConfig::AddMemoryFootprint(report);
+    report.arguments += value_.capacity() * sizeof(bool*) + actions_.capacity() * sizeof(Action);
+    report.values += cvalue_.size() * sizeof(bool);
+}
 } // namespace ArgumentParser
@@ -3,12 +3,34 @@
 #ifndef ARG_PARSER_PAWKORCHAGIN_ARG_PARSER_H
 #define ARG_PARSER_PAWKORCHAGIN_ARG_PARSER_H
 
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
 #include <iostream>
-#include <map>
-#include <set>
+#include <limits>
+#include <memory>
+#include <regex>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "bit_set.h"
+#include "generator.h"
+#include "int_range_set.h"
+#include "perfect_hash.h"
+#include "ring_buffer.h"
+#include "shared_results.h"
+#include "shell_lexer.h"
+#include "small_function.h"
+#include "string_map.h"
+#include "string_pool.h"
+#include "thread_pool.h"
+
 template<class T>
 std::ostream& operator<<(std::ostream& out, const std::vector<T> vec) {
     out << "{";
@@ -27,105 +49,419 @@ enum class ArgumentCheckStatus {
     kCorrectArgument, kParsingFailure, kIncorrectArgument
 };
 
+enum class TokenKind {
+    kArgument, kIntPositional, kStringPositional, kInvalidPositional, kOther
+};
+
+// Positional values of a long command line converted ahead on the pool, empty when parsing is sequential
+struct ClassifiedTokens {
+    std::vector<TokenKind> kinds;
+    std::vector<int> int_values;
+    std::vector<std::string> str_values;
+};
+
+enum class ParseEventKind {
+    kFlag, kValue, kPositional, kPassThrough, kHelp, kError
+};
+
+// One decision of the parser. argument refers to the parser's string pool,
+// value and the token of an error refer to the parsed command line
+struct ParseEvent {
+    ParseEventKind kind;
+    std::string_view argument;
+    std::string_view value;
+    size_t position;
+};
+
+// Random access view of a command line: string_views, strings and argv are read in place, without a copy
+class TokenRange {
+    public:
+        TokenRange(std::span<const std::string_view> tokens) : views_(tokens.data()), size_(tokens.size()) {}
+
+        TokenRange(std::span<const std::string> tokens) : strings_(tokens.data()), size_(tokens.size()) {}
+
+        TokenRange(const std::vector<std::string_view>& tokens) : TokenRange(std::span(tokens)) {}
+
+        TokenRange(const std::vector<std::string>& tokens) : TokenRange(std::span(tokens)) {}
+
+        TokenRange(int argc, char** argv) : argv_(argv), size_(static_cast<size_t>(argc)) {}
+
+        [[nodiscard]] std::string_view operator[](const size_t i) const {
+            if (views_ != nullptr)
+                return views_[i];
+            if (strings_ != nullptr)
+                return strings_[i];
+            return argv_[i];
+        }
+
+        [[nodiscard]] size_t Size() const {
+            return size_;
+        }
+
+    private:
+        const std::string_view* views_ = nullptr;
+        const std::string* strings_ = nullptr;
+        char** argv_ = nullptr;
+        size_t size_ = 0;
+};
+
+enum class PathError : uint8_t {
+    kNone, kMissing, kNotDirectory, kNotReadable
+};
+
+// Filesystem check of one path argument value. It is done on a worker thread while parsing goes on,
+// the error is known once Parse has returned
+struct PathCheck {
+    static constexpr uint8_t kMustExist = 1 << 0;
+    static constexpr uint8_t kIsDirectory = 1 << 1;
+    static constexpr uint8_t kReadable = 1 << 2;
+
+    std::string_view argument;
+    std::string path;
+    size_t position;
+    uint8_t checks;
+    PathError error = PathError::kNone;
+};
+
+// Outcome of ParseBatch: the events of line i are events[lines[i].begin, lines[i].end),
+// a failed line ends with its kError event. Values refer to the parsed lines
+struct BatchResult {
+    struct Line {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        bool ok = false;
+    };
+
+    std::vector<Line> lines;
+    std::vector<ParseEvent> events;
+    std::vector<std::deque<std::string>> unescaped; // values not found in the lines as they are, like quoted tokens
+
+    [[nodiscard]] std::span<const ParseEvent> Events(size_t line) const;
+};
+
+// Lets choice sets be probed with a std::string_view without building a std::string
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view str) const {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+constexpr size_t kNoArgument = std::numeric_limits<size_t>::max();
+
+enum class ArgumentType {
+    kNone, kFlag, kInt, kString, kEnum
+};
+
+// Parse tracing is compiled in only with ARG_PARSER_ENABLE_TRACE, otherwise ARG_PARSER_TRACE expands to nothing
+#ifdef ARG_PARSER_ENABLE_TRACE
+#define ARG_PARSER_TRACE(...) __VA_ARGS__
+#else
+#define ARG_PARSER_TRACE(...)
+#endif
+
+#ifndef ARG_PARSER_TRACE_CAPACITY
+#define ARG_PARSER_TRACE_CAPACITY 256
+#endif
+
+// Branch the parser took for a token
+enum class TraceDecision : uint8_t {
+    kHelp, kExactMatch, kKeyAlias, kEqualsSplit, kBundle, kPositional, kPositionalRun, kUnknown
+};
+
+// argument refers to the parser's string pool, it is empty for kUnknown
+struct TraceEvent {
+    uint32_t token;
+    TraceDecision decision;
+    std::string_view argument;
+};
+
+using TraceBuffer = RingBuffer<TraceEvent, ARG_PARSER_TRACE_CAPACITY>;
+
+// Typed dense index of an argument, filled by ArgParser::Handle and read by ArgParser::Get without a name lookup
+template<class T>
+class ArgHandle {
+    public:
+        // Vector handles are for MultiValue() arguments, the others for single value ones
+        static constexpr bool kIsMulti = std::is_same_v<T, std::vector<int>>
+                                         || std::is_same_v<T, std::vector<std::string>>;
+
+        explicit operator bool() const {
+            return id_ != kNoArgument;
+        }
+
+    private:
+        friend class ArgParser;
+
+        size_t id_ = kNoArgument;
+};
+
+// Bytes held by a parser schema, counted from container capacities
+struct MemoryFootprintReport {
+    size_t strings = 0;
+    size_t arguments = 0;
+    size_t index = 0;
+    size_t values = 0;
+
+    [[nodiscard]] size_t Total() const {
+        return strings + arguments + index + values;
+    }
+};
+
+// Arguments of one type form a structure of arrays indexed by a dense id,
+// names, keys and descriptions are kept in the parser's StringPool
 class BaseArgumentConfig {
     public:
         virtual ~BaseArgumentConfig() = default;
-        [[nodiscard]] std::string GetByKey(const std::string&) const;
-        [[nodiscard]] std::string GetDescription(const std::string&) const;
-        [[nodiscard]] bool KeyContains(const std::string&) const;
-        [[nodiscard]] bool Contains(const std::string&) const;
-        void SetArgument(const std::string&, const std::string&, const std::string& desc = "");
-        virtual void MakeMulti(const std::string&);
-        [[nodiscard]] bool IsMultiValueArgument(const std::string&) const;
-        [[nodiscard]] std::vector<std::string> GetUsedArgumentsList() const;
-        [[nodiscard]] bool IsDefault(const std::string&) const;
-        [[nodiscard]] std::vector<std::string> GetKeyArgumentsList() const;
-        std::string GetArgumentHelpDescription(const char*, const std::string&) const;
+        // Id of the argument with this name or key, kNoArgument if there is none
+        [[nodiscard]] size_t Find(const StringPool&, std::string_view) const;
+        // Stays valid until the next argument is added to the parser
+        [[nodiscard]] std::string_view GetName(const StringPool&, size_t) const;
+        [[nodiscard]] std::string_view GetDescription(const StringPool&, size_t) const;
+        // Calls function(name, id) for every name and key
+        template<class F>
+        void ForEachName(const StringPool& pool, F function) const {
+            index_.ForEach([&](const StringPool::Ref ref, const uint32_t id) { function(pool.View(ref), id); });
+        }
+        [[nodiscard]] size_t Size() const;
+        // Index of the argument among the arguments of all types
+        [[nodiscard]] size_t GetBit(size_t) const;
+        void SetBit(size_t, size_t);
+        virtual void MakeMulti(size_t);
+        [[nodiscard]] bool IsMultiValueArgument(size_t) const;
+        [[nodiscard]] bool IsDefault(size_t) const;
+        // A default callable is set, it is computed at the end of a parse without the argument
+        void SetLazyDefault(size_t);
+        [[nodiscard]] bool IsStored(size_t) const;
+        void SetValuesCount(size_t, size_t, size_t);
+        [[nodiscard]] size_t GetValuesLeft(size_t) const;
+        [[nodiscard]] bool HasEnoughValues(size_t) const;
+        void ResetValuesCount();
+        // Forget what the last parse stored, keeping defaults and bindings
+        virtual void ResetValues();
+        // Ids ordered by name, the order of help
+        [[nodiscard]] std::vector<size_t> GetSortedArguments(const StringPool&) const;
+        std::string GetArgumentHelpDescription(const StringPool&, std::string_view, size_t) const;
+        virtual void AddMemoryFootprint(MemoryFootprintReport&) const;
 
-    private:
-        struct ArgumentMainData {
-            std::string key_;
-            std::string desc_;
+    protected:
+        enum Property : uint8_t {
+            kDefault = 1 << 0,
+            kMulti = 1 << 1,
+            kStored = 1 << 2, // bound by StoreValue, defaulted or parsed
+            kBound = 1 << 3,
+            kLazyDefault = 1 << 4,
         };
 
-    protected:
-        // template<class T>
-        // std::map<std::string, std::vector<T>> cvalues_;
-        std::map<std::string, std::string> keys_;
-        std::map<std::string, ArgumentMainData> used_;
-        std::set<std::string> is_default_;
-        std::set<std::string> is_multi_;
+        size_t AddArgument(StringPool&, std::string_view, std::string_view, std::string_view);
+        void CountValues(size_t, size_t);
+        [[nodiscard]] size_t GetReservation(size_t, size_t) const;
+
+        std::vector<StringPool::Ref> names_;
+        std::vector<StringPool::Ref> keys_;
+        std::vector<StringPool::Ref> descs_;
+        std::vector<uint8_t> properties_;
+        std::vector<uint32_t> bits_;
+        std::vector<uint32_t> min_count_;
+        std::vector<uint32_t> max_count_;
+        std::vector<uint32_t> values_count_; // values given in the current parse
+        NameIndex index_; // names and keys
 };
 
 class IntArgumentConfig final : public BaseArgumentConfig {
     public:
-        void PutValue(const std::string& name, int* value);
-        void PutValues(const std::string& name, std::vector<int>* values);
-        void PutPositional(const std::string& arg);
-        int*& GetValue(const std::string&);
-        std::vector<int>*& GetValues(const std::string& name);
-        [[nodiscard]] std::string GetPositional() const;
+        IntArgumentConfig() = default;
+
+        // Copies the schema only: values are owned by the copy, bound variables and actions are dropped
+        IntArgumentConfig(const IntArgumentConfig&);
+
+        using Action = SmallFunction<void(int)>;
+
+        size_t SetArgument(StringPool&, std::string_view, std::string_view, std::string_view);
+        void PutValue(size_t, int* value);
+        void PutValues(size_t, std::vector<int>* values);
+        void PutPositional(size_t);
+        int& GetValue(size_t);
+        std::vector<int>& GetValues(size_t);
+        [[nodiscard]] size_t GetPositional() const;
         [[nodiscard]] bool IsPositional() const;
-        void CreateValue(const std::string&, int);
-        void CreateValues(const std::string&);
-        void AddValue(const std::string&, int);
-        [[nodiscard]] bool IsStored(const std::string&) const;
-        void SetDefault(const std::string&, int);
-        void SetParcedArgument(const std::string&, int);
-        [[nodiscard]] std::string GetExtraArgumentsDescription(const std::string&) const;
+        void SetDefault(size_t, int);
+        void SetParcedArgument(size_t, int);
+        void SetParcedArguments(size_t, std::span<const int>);
+        void ResetValues() override;
+        void ReserveValues(size_t, size_t);
+        void SetRange(size_t, int, int);
+        void SetChoices(size_t, std::initializer_list<int>);
+        void SetAction(size_t, Action);
+        [[nodiscard]] bool IsValid(size_t, int) const;
+        [[nodiscard]] std::string GetExtraArgumentsDescription(size_t) const;
+        void AddMemoryFootprint(MemoryFootprintReport&) const override;
 
     private:
-        std::map<std::string, int*> names_;
-        std::map<std::string, std::vector<int>*> multi_;
-        std::map<std::string, int> cvalue_;
-        std::map<std::string, std::vector<int> > cvalues_;
-        std::string positional_{};
-        bool is_positional_ = false;
+        struct IntValidator {
+            int min_ = std::numeric_limits<int>::min();
+            int max_ = std::numeric_limits<int>::max();
+            std::unordered_set<int> choices_;
+        };
+
+        IntValidator& GetValidator(size_t);
+
+        std::vector<int*> value_; // bound variable or the owned cvalue_ slot
+        std::vector<std::vector<int>*> values_;
+        std::deque<int> cvalue_;
+        std::deque<std::vector<int>> cvalues_;
+        std::vector<uint32_t> validator_;
+        std::vector<IntValidator> validators_;
+        std::vector<Action> actions_;
+        size_t positional_ = kNoArgument;
 };
 
 class StringArgumentConfig final : public BaseArgumentConfig {
     public:
-        void PutValue(const std::string& name, std::string* value);
-        void PutValues(const std::string& name, std::vector<std::string>* values);
-        void PutPositional(const std::string& arg);
-        std::string*& GetValue(const std::string& name);
-        std::vector<std::string>*& GetValues(const std::string& name);
-        [[nodiscard]] std::string GetPositional() const;
+        StringArgumentConfig() = default;
+
+        // Copies the schema only: values are owned by the copy, bound variables and actions are dropped
+        StringArgumentConfig(const StringArgumentConfig&);
+
+        using Action = SmallFunction<void(std::string_view)>;
+
+        size_t SetArgument(StringPool&, std::string_view, std::string_view, std::string_view);
+        void PutValue(size_t, std::string* value);
+        void PutValues(size_t, std::vector<std::string>* values);
+        void PutPositional(size_t);
+        std::string& GetValue(size_t);
+        std::vector<std::string>& GetValues(size_t);
+        [[nodiscard]] size_t GetPositional() const;
         [[nodiscard]] bool IsPositional() const;
-        void CreateValue(const std::string&, const std::string&);
-        void CreateValues(const std::string&);
-        void AddValue(const std::string&, const std::string&);
-        [[nodiscard]] bool IsStored(const std::string&) const;
-        void SetDefault(const std::string&, const std::string&);
-        void SetParcedArgument(const std::string&, const std::string&);
-        [[nodiscard]] std::string GetExtraArgumentsDescription(const std::string&) const;
-        // void CreateValues(std::string, const std::string&);
-        // void CreateValues(std::string, )
-        // [[nodiscard]] bool IsSingleArgument(std::string) const;
+        void SetDefault(size_t, const std::string&);
+        void SetParcedArgument(size_t, std::string_view);
+        void SetParcedArguments(size_t, std::span<std::string>);
+        // Counts the values appended to GetValues() from the index on and calls the action for each
+        void SetParcedValues(size_t, size_t);
+        void ResetValues() override;
+        void ReserveValues(size_t, size_t);
+        void SetChoices(size_t, std::initializer_list<std::string_view>);
+        void SetPattern(size_t, const std::string&);
+        void SetUtf8(size_t);
+        // Values are file paths, checked by the parser with PathCheck flags
+        void MakePath(size_t);
+        void AddPathChecks(size_t, uint8_t);
+        [[nodiscard]] bool IsPath(size_t) const;
+        [[nodiscard]] uint8_t GetPathChecks(size_t) const;
+        void SetGlob(size_t);
+        [[nodiscard]] bool IsGlob(size_t) const;
+        // KEY=VALUE values go into a StringMap instead of the values vector
+        void MakeMap(size_t);
+        void SetUniqueKeys(size_t);
+        [[nodiscard]] bool IsMap(size_t) const;
+        [[nodiscard]] const StringMap& GetMap(size_t) const;
+        // Range expressions go into an IntRangeSet instead of the values vector.
+        // They are not checked by IsValid, SetParcedRanges parses them once and is false for a malformed one
+        void MakeRangeSet(size_t);
+        [[nodiscard]] bool SetParcedRanges(size_t, std::string_view);
+        [[nodiscard]] bool IsRangeSet(size_t) const;
+        [[nodiscard]] const IntRangeSet& GetRangeSet(size_t) const;
+        void SetAction(size_t, Action);
+        [[nodiscard]] bool IsValid(size_t, std::string_view) const;
+        [[nodiscard]] std::string GetExtraArgumentsDescription(size_t) const;
+        void AddMemoryFootprint(MemoryFootprintReport&) const override;
 
     private:
-        std::map<std::string, std::string*> names_;
-        std::map<std::string, std::vector<std::string>*> multi_;
-        std::map<std::string, std::string> cvalue_;
-        std::map<std::string, std::vector<std::string> > cvalues_;
-        std::string positional_{};
-        bool is_positional = false;
+        struct StringValidator {
+            std::unordered_set<std::string, StringHash, std::equal_to<>> choices_;
+            std::shared_ptr<const std::regex> pattern_;
+            bool is_utf8_ = false;
+            bool is_path_ = false;
+            bool is_glob_ = false;
+            uint8_t path_checks_ = 0;
+        };
+
+        struct KeyValueMap {
+            StringMap map_;
+            bool is_unique_keys_ = false; // a repeated key fails parsing instead of replacing the value
+        };
+
+        StringValidator& GetValidator(size_t);
+
+        std::vector<std::string*> value_; // bound variable or the owned cvalue_ slot
+        std::vector<std::vector<std::string>*> values_;
+        std::deque<std::string> cvalue_;
+        std::deque<std::vector<std::string>> cvalues_;
+        std::vector<uint32_t> validator_;
+        std::vector<StringValidator> validators_;
+        std::vector<uint32_t> map_;
+        std::deque<KeyValueMap> maps_;
+        std::vector<uint32_t> range_set_;
+        std::deque<IntRangeSet> range_sets_;
+        std::vector<Action> actions_;
+        size_t positional_ = kNoArgument;
 };
 
 class FlagConfig final : public BaseArgumentConfig {
     public:
-        void PutValue(const std::string&, bool*);
-        void MakeMulti(const std::string&) override;
-        bool*& GetValue(const std::string&);
-        void CreateValue(const std::string&);
-        void CreateValue(const std::string&, bool);
-        void SetDefault(const std::string&, bool);
-        [[nodiscard]] bool IsStored(const std::string&) const;
-        [[nodiscard]] std::string GetExtraArgumentsDescription(const std::string&) const;
+        FlagConfig() = default;
+
+        // Copies the schema only: values are owned by the copy, bound variables and actions are dropped
+        FlagConfig(const FlagConfig&);
+
+        using Action = SmallFunction<void()>;
+
+        size_t SetArgument(StringPool&, std::string_view, std::string_view, std::string_view);
+        void PutValue(size_t, bool*);
+        void MakeMulti(size_t) override;
+        bool& GetValue(size_t);
+        void SetParcedArgument(size_t);
+        void SetDefault(size_t, bool);
+        void SetAction(size_t, Action);
+        [[nodiscard]] std::string GetExtraArgumentsDescription(size_t) const;
+        void AddMemoryFootprint(MemoryFootprintReport&) const override;
+
+    private:
+        std::vector<bool*> value_; // bound variable or the owned cvalue_ slot
+        std::deque<bool> cvalue_;
+        std::vector<Action> actions_;
+};
+
+class EnumArgumentConfig final : public BaseArgumentConfig {
+    public:
+        EnumArgumentConfig() = default;
+
+        // Copies the schema only: values are owned by the copy, bound variables and actions are dropped
+        EnumArgumentConfig(const EnumArgumentConfig&);
+
+        // Decodes a value straight into the stored enum, false if the name is not in the table
+        using Assign = bool (*)(std::string_view, void*);
+        using NameOf = std::string_view (*)(const void*);
+        using Clone = std::shared_ptr<void> (*)(const void*);
+        // Gets the name of the parsed enumerator
+        using Action = SmallFunction<void(std::string_view)>;
+
+        size_t SetArgument(StringPool&, std::string_view, std::string_view, std::string_view);
+        void SetType(StringPool&, size_t, Assign, NameOf, Clone, std::string_view choices,
+                     std::shared_ptr<void> storage, const std::type_info&);
+        void PutValue(size_t, void*, const std::type_info&);
+        void* GetValue(size_t, const std::type_info&);
+        // Slot of the default, apart from the parsed value whether a variable is bound or not
+        void* GetDefault(size_t);
+        [[nodiscard]] std::string_view GetChoices(const StringPool&, size_t) const;
+        [[nodiscard]] std::string_view GetValueName(size_t) const;
+        void SetDefault(size_t);
+        void SetAction(size_t, Action);
+        [[nodiscard]] bool SetParcedArgument(size_t, std::string_view);
+        [[nodiscard]] std::string GetExtraArgumentsDescription(size_t) const;
+        void AddMemoryFootprint(MemoryFootprintReport&) const override;
 
     private:
-        std::map<std::string, bool*> names_; // [name, stored value]
-        std::map<std::string, bool> cvalue_;
+        std::vector<Assign> assign_;
+        std::vector<NameOf> name_of_;
+        std::vector<Clone> clone_;
+        std::vector<StringPool::Ref> choices_;
+        std::vector<std::shared_ptr<void>> storage_; // parsed value of an unbound argument
+        std::vector<std::shared_ptr<void>> default_;
+        std::vector<void*> value_; // bound variable or storage_
+        std::vector<const std::type_info*> type_;
+        std::vector<Action> actions_;
 };
 
 class ArgParser {
@@ -138,12 +474,48 @@ class ArgParser {
 
         bool Parse(int argc, char** argv);
 
+        // Splits a whole command string with ShellLexer, the program name comes first. Not an overload of Parse,
+        // so Parse({"app", "--x"}) keeps going to the vector overload
+        bool ParseCommandLine(std::string_view command);
+
+        // Lazy form of Parse: values are stored as each event is produced, parsing stops after an error event.
+        // args must outlive the generator
+        Generator<ParseEvent> Events(std::span<const std::string_view> args);
+
+        Generator<ParseEvent> Events(const std::vector<std::string>& args);
+
+        Generator<ParseEvent> Events(int argc, char** argv);
+
+        // Parses independent whitespace separated command lines, program name first, against this schema.
+        // Lines are spread over the Parallel() pool or over all hardware threads, each worker parses with
+        // its own copy of the schema, so bound variables and actions are not touched
+        [[nodiscard]] BatchResult ParseBatch(std::span<const std::string_view> lines) const;
+
+        [[nodiscard]] BatchResult ParseBatch(const std::vector<std::string>& lines) const;
+
         ArgParser& AddFlag(const std::string& name, const std::string& desc = "");
 
         ArgParser& AddFlag(const std::string&,
                            const std::string&,
                            const std::string& desc);
 
+        ArgParser& AddPathArgument(const std::string& key, const std::string& name, const std::string& desc);
+
+        ArgParser& AddPathArgument(const std::string& name, const std::string& desc = "");
+
+        // Repeated "1-100,200,300-400" argument, the union of the ranges is read with GetRangeSet
+        ArgParser& AddRangeArgument(const std::string& key, const std::string& name, const std::string& desc);
+
+        ArgParser& AddRangeArgument(const std::string& name, const std::string& desc = "");
+
+        // Repeated KEY=VALUE argument, the pairs are split while parsing and read with GetMap
+        ArgParser& AddMapArgument(const std::string& key, const std::string& name, const std::string& desc);
+
+        ArgParser& AddMapArgument(const std::string& name, const std::string& desc = "");
+
+        // A key given twice to the last added map argument fails parsing, by default the last value wins
+        ArgParser& UniqueKeys();
+
         ArgParser& AddStringArgument(const std::string&,
                                      const std::string&,
                                      const std::string& desc);
@@ -157,6 +529,14 @@ class ArgParser {
 
         ArgParser& AddIntArgument(const std::string&, const std::string& = "");
 
+        template<const auto& Table>
+        ArgParser& AddEnumArgument(const std::string&,
+                                   const std::string&,
+                                   const std::string& desc);
+
+        template<const auto& Table>
+        ArgParser& AddEnumArgument(const std::string&, const std::string& = "");
+
         ArgParser& AddHelp(const std::string&);
 
         ArgParser& StoreValue(bool&);
@@ -165,7 +545,10 @@ class ArgParser {
 
         ArgParser& StoreValue(std::string&);
 
-        ArgParser& MultiValue(uint min_count = 0);
+        template<class E> requires std::is_enum_v<E>
+        ArgParser& StoreValue(E&);
+
+        ArgParser& MultiValue(uint min_count = 0, uint max_count = std::numeric_limits<uint>::max());
 
         ArgParser& StoreValues(std::vector<std::string>&);
 
@@ -173,12 +556,59 @@ class ArgParser {
 
         ArgParser& Positional();
 
+        // Values of arguments declared with Field() are written into this object, calling Bind again
+        // with another object of the same type moves all fields to it. Once fields are declared,
+        // an object of another type is rejected and the old binding is kept
+        template<class S>
+        ArgParser& Bind(S& target);
+
+        // Store the last added argument in a member of the bound object, e.g. Field(&Options::sum)
+        template<class S, class T>
+        ArgParser& Field(T S::* member);
+
         std::string& GetStringValue(const char*);
 
+        const StringMap& GetMap(const std::string&);
+
+        const IntRangeSet& GetRangeSet(const std::string&);
+
+        // Checks of path values given in the last parse, in argument order, all of them done once the parse ended
+        [[nodiscard]] const std::deque<PathCheck>& PathChecks() const;
+
         int& GetIntValue(const std::string&);
 
         bool& GetFlag(const std::string&);
 
+        template<class E> requires std::is_enum_v<E>
+        E& GetEnumValue(const std::string&);
+
+        // Fill the handle of the last added argument, the type must match the argument, vectors after MultiValue()
+        ArgParser& Handle(ArgHandle<int>&);
+
+        ArgParser& Handle(ArgHandle<std::vector<int>>&);
+
+        ArgParser& Handle(ArgHandle<std::string>&);
+
+        ArgParser& Handle(ArgHandle<std::vector<std::string>>&);
+
+        ArgParser& Handle(ArgHandle<bool>&);
+
+        template<class E> requires std::is_enum_v<E>
+        ArgParser& Handle(ArgHandle<E>&);
+
+        int& Get(ArgHandle<int>);
+
+        std::vector<int>& Get(ArgHandle<std::vector<int>>);
+
+        std::string& Get(ArgHandle<std::string>);
+
+        std::vector<std::string>& Get(ArgHandle<std::vector<std::string>>);
+
+        bool& Get(ArgHandle<bool>);
+
+        template<class E> requires std::is_enum_v<E>
+        E& Get(ArgHandle<E>);
+
         [[nodiscard]] bool Help() const;
 
         [[nodiscard]] std::string HelpDescription() const;
@@ -189,20 +619,477 @@ class ArgParser {
 
         ArgParser& Default(const char*);
 
+        template<class E> requires std::is_enum_v<E>
+        ArgParser& Default(E);
+
+        // Lazy default: function returns int, bool, a string or the enum and runs only at the end of the first
+        // successful parse that doesn't give the argument, the result is then kept as an ordinary default.
+        // ParseBatch copies of the schema see it only if it was computed before
+        template<class F> requires std::is_invocable_v<F&>
+        ArgParser& Default(F function);
+
+        // The variable gives the value when the argument is not on the command line: command line, then
+        // environment, then default. The environment is scanned once per parse, not with getenv per argument.
+        // Flags take 1, true, yes, on or 0, false, no, off and an empty value
+        ArgParser& Env(std::string_view variable);
+
+        // Validators are checked as each value is converted, a bad value fails Parse with the offending token
+        ArgParser& Range(int min, int max);
+
+        ArgParser& Choices(std::initializer_list<int>);
+
+        ArgParser& Choices(std::initializer_list<std::string_view>);
+
+        ArgParser& Matches(const std::string& pattern);
+
+        // String values must be well formed UTF-8
+        ArgParser& Utf8();
+
+        // Values with *, ? or [ are expanded against the filesystem, ** matches any number of directories.
+        // Matches are stored in sorted order like a shell would pass them. Only for MultiValue() arguments
+        ArgParser& Glob();
+
+        // Path values are checked with stat and access on a small thread pool while the command line is parsed,
+        // failures are printed in argument order and make Parse return false
+        ArgParser& MustExist();
+
+        ArgParser& IsDirectory();
+
+        ArgParser& Readable();
+
+        // Called as each value is parsed, before the following tokens: with no arguments for a flag,
+        // with the int for an int argument and with the token for string and enum arguments
+        template<class F>
+        ArgParser& Action(F action);
+
+        // Parsing fails if more than one of these arguments is given
+        ArgParser& MutuallyExclusive(std::initializer_list<std::string_view> names);
+
+        // Parsing fails if the last added argument is given without this one, which must be added before
+        ArgParser& Requires(std::string_view name);
+
+        // Convert long positional runs on a thread pool, threads = 0 uses all hardware threads
+        ArgParser& Parallel(size_t threads = 0);
+
+        // Unknown arguments and everything after "--" are reported as kPassThrough events instead of errors
+        ArgParser& PassThrough();
+
+        // Passed through argv pointers of the last successful Parse(argc, argv), in order. The storage behind
+        // the span ends with a nullptr, so data() can be given to execv as is
+        [[nodiscard]] std::span<char* const> PassThroughArgs() const;
+
+        [[nodiscard]] MemoryFootprintReport MemoryFootprint() const;
+
+        // Writes the current values under all names and keys into a sealed memfd, -1 on failure.
+        // A worker started with exec attaches to the inherited fd with SharedResults::Attach
+        [[nodiscard]] int ExportResults();
+
+#ifdef ARG_PARSER_ENABLE_TRACE
+        // Decisions of the last parse, the newest ARG_PARSER_TRACE_CAPACITY of them are kept
+        [[nodiscard]] const TraceBuffer& Trace() const;
+
+        // One line per kept decision, meant to be printed when Parse fails
+        void DumpTrace(std::ostream& out) const;
+#endif
+
     private:
+        friend class PushParser;
+
+        // Environment variable giving the value of an argument missing from the command line
+        struct EnvBinding {
+            ArgumentType type;
+            size_t id;
+        };
+
+        // Waits for the queued path checks when a parse ends, early failures and abandoned generators included
+        struct PathCheckWait {
+            ArgParser& parser;
+
+            ~PathCheckWait() {
+                parser.WaitPathChecks();
+            }
+        };
+
+        // A default which is not computed yet
+        struct LazyDefault {
+            ArgumentType type;
+            size_t id;
+            SmallFunction<void(ArgParser&)> resolve; // calls Default with the value for the current argument
+        };
+
+        // An argument stored at a fixed offset inside the bound object
+        struct FieldBinding {
+            size_t id;
+            size_t offset;
+            void (*bind)(ArgParser&, size_t, void*);
+        };
+
+        ArgParser(const ArgParser&);
+
+        // A handle Handle() refused to fill has no argument to read, like an unknown name in GetIntValue
+        template<class T>
+        static void CheckHandle(const ArgHandle<T> handle) {
+            if (!handle) {
+                std::cerr << "Error: Try get value through an empty handle\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        void ResetValues();
+        void RegisterArgument(BaseArgumentConfig&, size_t);
+        void MakeOptional();
+        [[nodiscard]] const BaseArgumentConfig* GetConfig(ArgumentType) const;
+        [[nodiscard]] BaseArgumentConfig* GetConfig(ArgumentType);
+        [[nodiscard]] size_t FindBit(std::string_view) const;
+        [[nodiscard]] std::string_view GetBitName(size_t) const;
         [[nodiscard]] bool IsArgumentCoincidence() const;
-        ArgumentCheckStatus IsArgument(const std::vector<std::string>&, size_t&);
+        [[nodiscard]] bool IsConstraintViolated() const;
+        [[nodiscard]] std::string_view GetCurrentName() const;
+        bool ParseTokens(TokenRange);
+        Generator<ParseEvent> ParseEvents(TokenRange);
+        void BeginParse();
+        // Emit is called with every ParseEvent in order, nothing is buffered
+        template<class Emit>
+        bool ParseToken(std::string_view, const std::string_view*, size_t, bool&, Emit&);
+        [[nodiscard]] bool TakesNextToken(std::string_view) const;
+        bool FinishParse(size_t, ParseEvent&);
+        [[nodiscard]] size_t FindHelp(TokenRange, size_t&);
+        template<class Emit>
+        bool ParseLine(TokenRange, Emit&);
+        // Parses the token at the index, or the whole run of classified positional values starting there,
+        // and moves the index to the last used token
+        template<class Emit>
+        bool ParseStep(TokenRange, size_t&, size_t, ClassifiedTokens&, Emit&);
+        void ResolveLazyDefaults();
+        bool ApplyEnvironment();
+        bool SetEnvValue(ArgumentType, size_t, std::string_view);
+        void AddPathChecks(uint8_t);
+        void CheckPath(size_t, std::string_view, size_t);
+        void WaitPathChecks();
+        ThreadPool& GetIoPool();
+        bool StoreString(size_t, std::string_view, size_t);
+#ifdef ARG_PARSER_ENABLE_TRACE
+        void TraceMatch(size_t, std::string_view, std::string_view);
+#endif
+        ArgumentCheckStatus IsArgument(std::string_view, const std::string_view*, bool&, ParseEvent&);
         [[nodiscard]] bool IsUnusedNoDefaultArgument() const;
+        [[nodiscard]] bool IsMissingMultiValues() const;
+        [[nodiscard]] bool IsArgumentName(std::string_view) const;
+        [[nodiscard]] bool IsBundle(std::string_view) const;
+        [[nodiscard]] TokenKind ClassifyToken(std::string_view, int&) const;
+        void ClassifyTokens(TokenRange, ClassifiedTokens&) const;
 
         std::string program_name_;
-        std::string cur_arg_{};
+        ArgumentType cur_type_ = ArgumentType::kNone;
+        size_t cur_id_ = kNoArgument;
 
         bool is_added_help_ = false;
+        bool is_pass_through_ = false;
+        bool is_coincidence_ = false; // a name is used by arguments of two types, found as arguments are added
+        size_t remaining_tokens_ = 0;
 
+        StringPool strings_;
         FlagConfig flags_;
         IntArgumentConfig int_args_;
         StringArgumentConfig str_args_;
+        EnumArgumentConfig enum_args_;
+
+        std::vector<std::pair<ArgumentType, size_t>> arguments_; // [bit, {type, id}]
+        BitSet required_; // no default and no bound variable
+        BitSet seen_; // given in the current parse
+        std::vector<BitSet> exclusive_groups_;
+        std::vector<std::pair<size_t, BitSet>> requirements_; // [bit, required bits]
+
+        void* bound_ = nullptr;
+        const std::type_info* bound_type_ = nullptr;
+        std::vector<FieldBinding> fields_;
+        std::vector<LazyDefault> lazy_defaults_;
+
+        NameIndex env_index_; // variable names, kept in strings_
+        std::vector<EnvBinding> env_bindings_;
+        std::string env_prefix_; // common to all variable names, lets environ entries be skipped cheaply
+
+        std::vector<char*> pass_through_args_; // nullptr terminated
+        std::vector<ParseEvent> token_events_; // events of one token in Events(), the capacity is kept
+
+#ifdef ARG_PARSER_ENABLE_TRACE
+        TraceBuffer trace_;
+#endif
+
+        std::unique_ptr<ThreadPool> pool_;
+        std::unique_ptr<ThreadPool> io_pool_; // started by the first path check or glob when there is no pool_
+        std::deque<PathCheck> path_checks_;
+};
+
+// Parses a command line fed one token at a time, for checking a line while it is typed. The state of Parse is
+// kept between calls, so each token costs about what it costs inside Parse. Tokens start after the program name,
+// the parser must outlive this object and must not be parsed by other means until Finish
+class PushParser {
+    public:
+        explicit PushParser(ArgParser& parser);
+
+        // Events the token completes. A value taking option gives its events with the next token,
+        // everything is ignored after an error or help. The span is valid until the next call
+        std::span<const ParseEvent> Feed(std::string_view token);
+
+        // Ends the line like the end of Parse: a pending option gets no value, then environment variables,
+        // path checks, required arguments and constraints. Ends with a kError event on failure
+        std::span<const ParseEvent> Finish();
+
+        // The last token is an option waiting for its value
+        [[nodiscard]] bool IsPending() const;
+
+        [[nodiscard]] bool IsFailed() const;
+
+    private:
+        void Step(const std::string_view* next);
+
+        ArgParser& parser_;
+        std::deque<std::string> tokens_; // event values refer to them
+        std::vector<ParseEvent> events_;
+        size_t pending_ = kNoArgument; // position of the token being parsed
+        bool is_separated_ = false;
+        bool is_failed_ = false;
+        bool is_done_ = false;
 };
+
+template<const auto& Table>
+ArgParser& ArgParser::AddEnumArgument(const std::string& key,
+                                      const std::string& name,
+                                      const std::string& desc) {
+    using Hash = PerfectHash<Table>;
+    using E = typename Hash::Enum;
+
+    std::string choices;
+    for (const auto& entry: Table) {
+        if (!choices.empty()) choices += '|';
+        choices += entry.name;
+    }
+
+    const size_t size = enum_args_.Size();
+    cur_type_ = ArgumentType::kEnum;
+    cur_id_ = enum_args_.SetArgument(strings_, key, name, desc);
+    RegisterArgument(enum_args_, size);
+    enum_args_.SetType(
+        strings_,
+        cur_id_,
+        [](const std::string_view str, void* value) {
+            const size_t index = Hash::Find(str);
+            if (index == Hash::kNotFound)
+                return false;
+            *static_cast<E*>(value) = Table[index].value;
+            return true;
+        },
+        [](const void* value) {
+            for (const auto& entry: Table) {
+                if (entry.value == *static_cast<const E*>(value))
+                    return entry.name;
+            }
+            return std::string_view();
+        },
+        [](const void* value) -> std::shared_ptr<void> {
+            return std::make_shared<E>(*static_cast<const E*>(value));
+        },
+        choices,
+        std::make_shared<E>(Table[0].value),
+        typeid(E));
+    return *this;
+}
+
+template<const auto& Table>
+ArgParser& ArgParser::AddEnumArgument(const std::string& name, const std::string& desc) {
+    return AddEnumArgument<Table>("", name, desc);
+}
+
+template<class E> requires std::is_enum_v<E>
+ArgParser& ArgParser::StoreValue(E& value) {
+    if (cur_type_ != ArgumentType::kEnum) {
+        std::cerr << "Error: Try store enum value of non-enum argument\n";
+        return *this;
+    }
+    if (enum_args_.IsDefault(cur_id_))
+        value = *static_cast<E*>(enum_args_.GetDefault(cur_id_));
+    enum_args_.PutValue(cur_id_, &value, typeid(E));
+    MakeOptional();
+    return *this;
+}
+
+template<class E> requires std::is_enum_v<E>
+E& ArgParser::GetEnumValue(const std::string& name) {
+    return *static_cast<E*>(enum_args_.GetValue(enum_args_.Find(strings_, name), typeid(E)));
+}
+
+template<class F>
+ArgParser& ArgParser::Action(F action) {
+    switch (cur_type_) {
+        case ArgumentType::kFlag:
+            if constexpr (std::is_invocable_v<F&>) {
+                flags_.SetAction(cur_id_, std::move(action));
+                return *this;
+            }
+            break;
+        case ArgumentType::kInt:
+            if constexpr (std::is_invocable_v<F&, int>) {
+                int_args_.SetAction(cur_id_, std::move(action));
+                return *this;
+            }
+            break;
+        case ArgumentType::kString:
+            if constexpr (std::is_invocable_v<F&, std::string_view>) {
+                str_args_.SetAction(cur_id_, std::move(action));
+                return *this;
+            }
+            break;
+        case ArgumentType::kEnum:
+            if constexpr (std::is_invocable_v<F&, std::string_view>) {
+                enum_args_.SetAction(cur_id_, std::move(action));
+                return *this;
+            }
+            break;
+        default:
+            break;
+    }
+
+    std::cerr << "Error: Action can't take the value of argument " << GetCurrentName() << '\n';
+    return *this;
+}
+
+template<class S>
+ArgParser& ArgParser::Bind(S& target) {
+    if (!fields_.empty() && *bound_type_ != typeid(S)) {
+        std::cerr << "Error: Try bind an object of another type than the bound fields' struct\n";
+        return *this;
+    }
+
+    bound_ = &target;
+    bound_type_ = &typeid(S);
+    for (const auto& field: fields_) {
+        field.bind(*this, field.id, reinterpret_cast<char*>(&target) + field.offset);
+    }
+    return *this;
+}
+
+template<class S, class T>
+ArgParser& ArgParser::Field(T S::* member) {
+    if (bound_type_ == nullptr || *bound_type_ != typeid(S)) {
+        std::cerr << "Error: Bind an object of the field's struct type first " << GetCurrentName() << '\n';
+        return *this;
+    }
+
+    ArgumentType type;
+    void (*bind)(ArgParser&, size_t, void*);
+    if constexpr (std::is_same_v<T, int>) {
+        type = ArgumentType::kInt;
+        bind = [](ArgParser& parser, const size_t id, void* field) {
+            parser.int_args_.PutValue(id, static_cast<int*>(field));
+        };
+    } else if constexpr (std::is_same_v<T, std::vector<int>>) {
+        type = ArgumentType::kInt;
+        bind = [](ArgParser& parser, const size_t id, void* field) {
+            parser.int_args_.PutValues(id, static_cast<std::vector<int>*>(field));
+        };
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        type = ArgumentType::kString;
+        bind = [](ArgParser& parser, const size_t id, void* field) {
+            parser.str_args_.PutValue(id, static_cast<std::string*>(field));
+        };
+    } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+        type = ArgumentType::kString;
+        bind = [](ArgParser& parser, const size_t id, void* field) {
+            parser.str_args_.PutValues(id, static_cast<std::vector<std::string>*>(field));
+        };
+    } else if constexpr (std::is_same_v<T, bool>) {
+        type = ArgumentType::kFlag;
+        bind = [](ArgParser& parser, const size_t id, void* field) {
+            parser.flags_.PutValue(id, static_cast<bool*>(field));
+        };
+    } else if constexpr (std::is_enum_v<T>) {
+        type = ArgumentType::kEnum;
+        bind = [](ArgParser& parser, const size_t id, void* field) {
+            if (parser.enum_args_.IsDefault(id))
+                *static_cast<T*>(field) = *static_cast<T*>(parser.enum_args_.GetDefault(id));
+            parser.enum_args_.PutValue(id, field, typeid(T));
+        };
+    } else {
+        static_assert(sizeof(T) == 0, "Field type must be int, std::string, bool, an enum or a vector of them");
+    }
+
+    if (cur_type_ != type) {
+        std::cerr << "Error: Field type doesn't match argument " << GetCurrentName() << '\n';
+        return *this;
+    }
+
+    S& target = *static_cast<S*>(bound_);
+    void* field = &(target.*member);
+    const auto offset = static_cast<size_t>(static_cast<char*>(field) - reinterpret_cast<char*>(&target));
+    fields_.push_back({cur_id_, offset, bind});
+    bind(*this, cur_id_, field);
+    MakeOptional();
+    return *this;
+}
+
+template<class E> requires std::is_enum_v<E>
+ArgParser& ArgParser::Handle(ArgHandle<E>& handle) {
+    if (cur_type_ != ArgumentType::kEnum) {
+        std::cerr << "Error: Try get enum handle of non-enum argument\n";
+        return *this;
+    }
+    enum_args_.GetValue(cur_id_, typeid(E));
+    handle.id_ = cur_id_;
+    return *this;
+}
+
+template<class E> requires std::is_enum_v<E>
+E& ArgParser::Get(const ArgHandle<E> handle) {
+    CheckHandle(handle);
+    return *static_cast<E*>(enum_args_.GetValue(handle.id_, typeid(E)));
+}
+
+template<class E> requires std::is_enum_v<E>
+ArgParser& ArgParser::Default(const E value) {
+    if (cur_type_ != ArgumentType::kEnum) {
+        std::cerr << "Error: Try set enum default of non-enum argument\n";
+        return *this;
+    }
+    *static_cast<E*>(enum_args_.GetValue(cur_id_, typeid(E))) = value;
+    *static_cast<E*>(enum_args_.GetDefault(cur_id_)) = value;
+    enum_args_.SetDefault(cur_id_);
+    MakeOptional();
+    return *this;
+}
+
+template<class F> requires std::is_invocable_v<F&>
+ArgParser& ArgParser::Default(F function) {
+    using R = std::decay_t<std::invoke_result_t<F&>>;
+    ArgumentType type;
+    if constexpr (std::is_same_v<R, bool>)
+        type = ArgumentType::kFlag;
+    else if constexpr (std::is_same_v<R, int>)
+        type = ArgumentType::kInt;
+    else if constexpr (std::is_enum_v<R>)
+        type = ArgumentType::kEnum;
+    else if constexpr (std::is_convertible_v<R, std::string_view>)
+        type = ArgumentType::kString;
+    else
+        static_assert(sizeof(R) == 0, "Default callable must return int, bool, a string or an enum");
+
+    if (cur_type_ != type) {
+        std::cerr << "Error: Try set lazy default of another type " << GetCurrentName() << '\n';
+        return *this;
+    }
+    if constexpr (std::is_enum_v<R>)
+        enum_args_.GetValue(cur_id_, typeid(R)); // exits on an enum of another type, as Default(E) does
+
+    GetConfig(cur_type_)->SetLazyDefault(cur_id_);
+    lazy_defaults_.push_back({type, cur_id_, [function = std::move(function)](ArgParser& parser) mutable {
+        if constexpr (std::is_convertible_v<R, std::string_view>)
+            parser.Default(std::string(std::string_view(function())).c_str());
+        else
+            parser.Default(function());
+    }});
+    MakeOptional();
+    return *this;
+}
 } // namespace ArgumentParser
 
 #endif // ARG_PARSER_PAWKORCHAGIN_ARG_PARSER_H
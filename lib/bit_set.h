@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_BIT_SET_H
+#define ARG_PARSER_PAWKORCHAGIN_BIT_SET_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ArgumentParser {
+// Growable set of dense argument indices, set operations work a 64 bit word at a time.
+// Words missing from the shorter operand are treated as zeros
+class BitSet {
+    public:
+        static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+        void Resize(const size_t bits) {
+            words_.resize((bits + 63) / 64, 0);
+        }
+
+        void Set(const size_t bit) {
+            if (bit / 64 >= words_.size())
+                Resize(bit + 1);
+            words_[bit / 64] |= uint64_t{1} << (bit % 64);
+        }
+
+        void Reset(const size_t bit) {
+            if (bit / 64 < words_.size())
+                words_[bit / 64] &= ~(uint64_t{1} << (bit % 64));
+        }
+
+        [[nodiscard]] bool Test(const size_t bit) const {
+            return bit / 64 < words_.size() && (words_[bit / 64] >> (bit % 64) & 1);
+        }
+
+        void Clear() {
+            std::ranges::fill(words_, 0);
+        }
+
+        BitSet& operator&=(const BitSet& other) {
+            for (size_t i = 0 ; i < words_.size() ; ++i)
+                words_[i] &= i < other.words_.size() ? other.words_[i] : 0;
+            return *this;
+        }
+
+        void AndNot(const BitSet& other) {
+            for (size_t i = 0 ; i < std::min(words_.size(), other.words_.size()) ; ++i)
+                words_[i] &= ~other.words_[i];
+        }
+
+        [[nodiscard]] bool Any() const {
+            return std::ranges::any_of(words_, [](const uint64_t word) { return word != 0; });
+        }
+
+        [[nodiscard]] size_t Count() const {
+            size_t count = 0;
+            for (const uint64_t word: words_)
+                count += std::popcount(word);
+            return count;
+        }
+
+        // First bit at or after from, kNone if there is none
+        [[nodiscard]] size_t FindNext(const size_t from) const {
+            for (size_t i = from / 64 ; i < words_.size() ; ++i) {
+                uint64_t word = words_[i];
+                if (i == from / 64)
+                    word &= ~uint64_t{0} << (from % 64);
+                if (word != 0)
+                    return i * 64 + std::countr_zero(word);
+            }
+            return kNone;
+        }
+
+        [[nodiscard]] size_t MemoryFootprint() const {
+            return words_.capacity() * sizeof(uint64_t);
+        }
+
+    private:
+        std::vector<uint64_t> words_;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_BIT_SET_H
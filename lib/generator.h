@@ -0,0 +1,118 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_GENERATOR_H
+#define ARG_PARSER_PAWKORCHAGIN_GENERATOR_H
+
+#include <coroutine>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace ArgumentParser {
+// Minimal lazy input range in the spirit of C++23 std::generator, which libstdc++ doesn't ship yet.
+// A yielded value lives until the generator is resumed again
+template<class T>
+class Generator {
+    public:
+        struct promise_type {
+            const T* value_ = nullptr;
+
+            Generator get_return_object() {
+                return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_always yield_value(const T& value) noexcept {
+                value_ = std::addressof(value);
+                return {};
+            }
+
+            void return_void() noexcept {
+            }
+
+            void unhandled_exception() {
+                throw;
+            }
+        };
+
+        class Iterator {
+            public:
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+
+                Iterator() = default;
+
+                explicit Iterator(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+                }
+
+                const T& operator*() const {
+                    return *handle_.promise().value_;
+                }
+
+                const T* operator->() const {
+                    return handle_.promise().value_;
+                }
+
+                Iterator& operator++() {
+                    handle_.resume();
+                    return *this;
+                }
+
+                void operator++(int) {
+                    ++*this;
+                }
+
+                bool operator==(std::default_sentinel_t) const {
+                    return handle_ == nullptr || handle_.done();
+                }
+
+            private:
+                std::coroutine_handle<promise_type> handle_ = nullptr;
+        };
+
+        Generator(Generator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+        }
+
+        Generator& operator=(Generator&& other) noexcept {
+            if (this != &other) {
+                if (handle_)
+                    handle_.destroy();
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+            return *this;
+        }
+
+        Generator(const Generator&) = delete;
+
+        Generator& operator=(const Generator&) = delete;
+
+        ~Generator() {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        Iterator begin() {
+            handle_.resume();
+            return Iterator(handle_);
+        }
+
+        std::default_sentinel_t end() const {
+            return {};
+        }
+
+    private:
+        explicit Generator(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+        }
+
+        std::coroutine_handle<promise_type> handle_;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_GENERATOR_H
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <span>
+
+#include "glob.h"
+
+namespace {
+namespace fs = std::filesystem;
+
+std::string Join(const std::string& dir, const std::string_view name) {
+    if (dir.empty())
+        return std::string(name);
+    if (dir.back() == '/')
+        return dir + std::string(name);
+    return dir + '/' + std::string(name);
+}
+
+bool IsDirectory(const std::string& path) {
+    std::error_code error;
+    return fs::is_directory(path.empty() ? "." : path, error);
+}
+
+// Calls function(name, is_directory, is_symlink) for every entry of dir, unreadable directories have no entries
+template<class F>
+void ForEachEntry(const std::string& dir, F function) {
+    std::error_code error;
+    for (fs::directory_iterator it(dir.empty() ? "." : dir, error), end ; !error && it != end ; it.increment(error)) {
+        std::error_code status_error;
+        function(it->path().filename().string(), it->is_directory(status_error), it->is_symlink(status_error));
+    }
+}
+
+// One expansion: every directory to list is a pool task, so each level of the tree is walked in parallel.
+// Matches are appended straight to the target, the walk stops once there are more than limit of them
+class Walker {
+    public:
+        Walker(const std::span<const std::string> components,
+               ArgumentParser::ThreadPool& pool,
+               const size_t limit,
+               std::vector<std::string>& matches)
+            : components_(components), pool_(pool), limit_(limit), matches_(matches), begin_(matches.size()) {}
+
+        // Expands components[component..] under path
+        void Walk(const std::string& path, const size_t component) {
+            if (is_over_limit_)
+                return;
+            if (component == components_.size()) {
+                Add(path);
+                return;
+            }
+
+            const std::string& pattern = components_[component];
+            const bool is_last = component + 1 == components_.size();
+
+            if (pattern == "**") {
+                // Trailing: every file and directory below. Otherwise zero directories, then one more level
+                // with ** still in front
+                if (!is_last)
+                    Walk(path, component + 1);
+                ForEachEntry(path, [&](const std::string& name, const bool is_directory, const bool is_symlink) {
+                    if (name.front() == '.')
+                        return;
+                    if (is_last)
+                        Add(Join(path, name));
+                    if (is_directory && !is_symlink)
+                        Spawn(Join(path, name), component);
+                });
+                return;
+            }
+
+            if (!ArgumentParser::IsGlobPattern(pattern)) {
+                const std::string next = Join(path, pattern);
+                std::error_code error;
+                if (is_last ? fs::exists(fs::symlink_status(next, error)) : IsDirectory(next))
+                    Walk(next, component + 1);
+                return;
+            }
+
+            ForEachEntry(path, [&](const std::string& name, const bool is_directory, bool) {
+                if (!ArgumentParser::MatchGlob(pattern, name))
+                    return;
+                if (is_last)
+                    Add(Join(path, name));
+                else if (is_directory)
+                    Spawn(Join(path, name), component + 1);
+            });
+        }
+
+        void Wait() {
+            for (size_t pending = pending_.load() ; pending != 0 ; pending = pending_.load())
+                pending_.wait(pending);
+        }
+
+        [[nodiscard]] bool IsOverLimit() const {
+            return is_over_limit_;
+        }
+
+    private:
+        void Spawn(std::string path, const size_t component) {
+            ++pending_;
+            pool_.Submit([this, path = std::move(path), component] {
+                Walk(path, component);
+                if (--pending_ == 0)
+                    pending_.notify_all();
+            });
+        }
+
+        void Add(std::string path) {
+            const std::lock_guard lock(mutex_);
+            if (matches_.size() - begin_ == limit_) {
+                is_over_limit_ = true;
+                return;
+            }
+            matches_.push_back(std::move(path));
+        }
+
+        std::span<const std::string> components_;
+        ArgumentParser::ThreadPool& pool_;
+        size_t limit_;
+        std::mutex mutex_;
+        std::vector<std::string>& matches_; // guarded by mutex_
+        size_t begin_;
+        std::atomic<size_t> pending_ = 0;
+        std::atomic<bool> is_over_limit_ = false;
+};
+
+bool MatchClass(const std::string_view pattern, size_t& pos, const char c) {
+    // pattern[pos] is '[', pos is moved past the closing ']'
+    size_t i = pos + 1;
+    const bool is_negated = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+    i += is_negated;
+    bool is_matched = false;
+    for (bool is_first = true ; i < pattern.size() && (is_first || pattern[i] != ']') ; is_first = false) {
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            is_matched |= pattern[i] <= c && c <= pattern[i + 2];
+            i += 3;
+        } else {
+            is_matched |= pattern[i] == c;
+            ++i;
+        }
+    }
+    pos = i + 1;
+    return is_matched != is_negated;
+}
+}
+
+namespace ArgumentParser {
+bool IsGlobPattern(const std::string_view str) {
+    return str.find_first_of("*?[") != std::string_view::npos;
+}
+
+bool MatchGlob(const std::string_view pattern, const std::string_view name) {
+    if (!name.empty() && name.front() == '.' && !pattern.empty() && pattern.front() != '.')
+        return false;
+
+    // Greedy with one backtrack point, enough for * since it can't match /
+    size_t p = 0;
+    size_t n = 0;
+    size_t star = std::string_view::npos;
+    size_t star_name = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_name = n;
+            continue;
+        }
+        if (p < pattern.size() && pattern[p] == '?') {
+            ++p;
+            ++n;
+            continue;
+        }
+        if (p < pattern.size() && pattern[p] == '[' && pattern.find(']', p + 2) != std::string_view::npos) {
+            size_t next = p;
+            if (MatchClass(pattern, next, name[n])) {
+                p = next;
+                ++n;
+                continue;
+            }
+        } else if (p < pattern.size() && pattern[p] == name[n]) {
+            ++p;
+            ++n;
+            continue;
+        }
+        if (star == std::string_view::npos)
+            return false;
+        p = star + 1;
+        n = ++star_name;
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+
+    return p == pattern.size();
+}
+
+bool Glob(const std::string_view pattern, ThreadPool& pool, const size_t limit, std::vector<std::string>& matches) {
+    std::vector<std::string> components;
+    for (size_t begin = 0 ; begin <= pattern.size() ;) {
+        const size_t end = std::min(pattern.find('/', begin), pattern.size());
+        // a/**/**/b walks the same directories as a/**/b
+        if (end > begin && (pattern.substr(begin, end - begin) != "**" || components.empty()
+                            || components.back() != "**"))
+            components.emplace_back(pattern.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    if (std::ranges::none_of(components, [](const std::string& component) { return IsGlobPattern(component); })) {
+        if (limit == 0)
+            return false;
+        matches.emplace_back(pattern);
+        return true;
+    }
+
+    const size_t begin = matches.size();
+    Walker walker(components, pool, limit, matches);
+    walker.Walk(pattern.starts_with('/') ? "/" : "", 0);
+    walker.Wait();
+    if (walker.IsOverLimit())
+        return false;
+
+    // Workers append in the order they finish, the new tail is sorted in place
+    const auto found = std::ranges::subrange(matches.begin() + static_cast<std::ptrdiff_t>(begin), matches.end());
+    std::ranges::sort(found);
+    matches.erase(std::ranges::unique(found).begin(), matches.end());
+    return true;
+}
+} // namespace ArgumentParser
@@ -0,0 +1,25 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_GLOB_H
+#define ARG_PARSER_PAWKORCHAGIN_GLOB_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace ArgumentParser {
+// True if the string has *, ? or [, the characters Glob expands
+[[nodiscard]] bool IsGlobPattern(std::string_view str);
+
+// Whole name match of one path component: * and ? don't match a leading dot, [abc], [a-z] and [!a] are classes
+[[nodiscard]] bool MatchGlob(std::string_view pattern, std::string_view name);
+
+// Appends the paths matching pattern in sorted order, a ** component matches any number of directories and
+// a trailing one every file below. Every directory level is walked in parallel on pool, symlinked directories
+// are not followed. False, with matches left partly appended, once more than limit paths match
+[[nodiscard]] bool Glob(std::string_view pattern, ThreadPool& pool, size_t limit, std::vector<std::string>& matches);
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_GLOB_H
@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "int_range_set.h"
+
+namespace {
+uint64_t CountElements(const ArgumentParser::IntRangeSet::Interval& interval) {
+    return static_cast<uint64_t>(int64_t{interval.last} - interval.first + 1);
+}
+}
+
+namespace ArgumentParser {
+bool IntRangeSet::Add(const std::string_view expression) {
+    const size_t size = intervals_.size();
+    const bool is_valid = ParseExpression(expression, [&](const int first, const int last) {
+        intervals_.push_back({first, last});
+    });
+    if (!is_valid) {
+        intervals_.resize(size);
+        return false;
+    }
+
+    Normalize(size);
+    return true;
+}
+
+void IntRangeSet::Add(const int first, const int last) {
+    intervals_.push_back({first, last});
+    Normalize(intervals_.size() - 1);
+}
+
+bool IntRangeSet::Contains(const int value) const {
+    const auto it = std::ranges::upper_bound(intervals_, value, {}, &Interval::first);
+    return it != intervals_.begin() && std::prev(it)->last >= value;
+}
+
+uint64_t IntRangeSet::Size() const {
+    return size_;
+}
+
+bool IntRangeSet::Empty() const {
+    return intervals_.empty();
+}
+
+std::span<const IntRangeSet::Interval> IntRangeSet::Intervals() const {
+    return intervals_;
+}
+
+IntRangeSet::Iterator IntRangeSet::begin() const {
+    return Iterator(intervals_.data(), intervals_.data() + intervals_.size());
+}
+
+IntRangeSet::Iterator IntRangeSet::end() const {
+    return Iterator(intervals_.data() + intervals_.size(), intervals_.data() + intervals_.size());
+}
+
+void IntRangeSet::Clear() {
+    intervals_.clear();
+    size_ = 0;
+}
+
+size_t IntRangeSet::MemoryFootprint() const {
+    return intervals_.capacity() * sizeof(Interval);
+}
+
+void IntRangeSet::Normalize(const size_t from) {
+    if (from == intervals_.size())
+        return;
+
+    // Only the new intervals are sorted, the old ones before the first new one stay as they are. In the usual
+    // "1-10,20,30-40" order that leaves just the last old interval to merge with
+    const auto middle = intervals_.begin() + static_cast<std::ptrdiff_t>(from);
+    std::ranges::sort(middle, intervals_.end(), {}, &Interval::first);
+    auto start = std::ranges::upper_bound(intervals_.begin(), middle, middle->first, {}, &Interval::first);
+    if (start != intervals_.begin())
+        --start;
+
+    // The count changes by what the merged part holds after minus what its old intervals held before
+    for (auto it = start ; it != middle ; ++it)
+        size_ -= CountElements(*it);
+    std::inplace_merge(start, middle, intervals_.end(), [](const Interval& lhs, const Interval& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    auto merged = start;
+    for (auto it = start + 1 ; it != intervals_.end() ; ++it) {
+        if (int64_t{it->first} <= int64_t{merged->last} + 1)
+            merged->last = std::max(merged->last, it->last);
+        else
+            *++merged = *it;
+    }
+    intervals_.erase(merged + 1, intervals_.end());
+
+    for (auto it = start ; it != intervals_.end() ; ++it)
+        size_ += CountElements(*it);
+}
+} // namespace ArgumentParser
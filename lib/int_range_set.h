@@ -0,0 +1,130 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_INT_RANGE_SET_H
+#define ARG_PARSER_PAWKORCHAGIN_INT_RANGE_SET_H
+
+#include <charconv>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+// Set of ints kept as sorted disjoint closed intervals, so "0-9999999" takes one interval, not ten million ints
+class IntRangeSet {
+    public:
+        struct Interval {
+            int first;
+            int last;
+        };
+
+        // Walks the elements without materializing them
+        class Iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = int;
+                using difference_type = std::ptrdiff_t;
+
+                Iterator() = default;
+
+                Iterator(const Interval* interval, const Interval* end)
+                    : interval_(interval), end_(end), value_(interval != end ? interval->first : 0) {
+                }
+
+                int operator*() const {
+                    return static_cast<int>(value_);
+                }
+
+                Iterator& operator++() {
+                    if (++value_ > interval_->last) {
+                        ++interval_;
+                        value_ = interval_ != end_ ? interval_->first : 0;
+                    }
+                    return *this;
+                }
+
+                Iterator operator++(int) {
+                    Iterator old = *this;
+                    ++*this;
+                    return old;
+                }
+
+                bool operator==(const Iterator& other) const {
+                    return interval_ == other.interval_ && value_ == other.value_;
+                }
+
+            private:
+                const Interval* interval_ = nullptr;
+                const Interval* end_ = nullptr;
+                int64_t value_ = 0; // past the last int of an interval without overflow
+        };
+
+        // Calls add(first, last) for each item of "1-100,200,-5--1", false on a malformed expression
+        template<class F>
+        static bool ParseExpression(std::string_view expression, F add);
+
+        // Unites the set with the expression, the set is unchanged if it is malformed
+        bool Add(std::string_view expression);
+
+        void Add(int first, int last);
+
+        [[nodiscard]] bool Contains(int value) const;
+
+        // Number of elements
+        [[nodiscard]] uint64_t Size() const;
+
+        [[nodiscard]] bool Empty() const;
+
+        [[nodiscard]] std::span<const Interval> Intervals() const;
+
+        [[nodiscard]] Iterator begin() const;
+
+        [[nodiscard]] Iterator end() const;
+
+        void Clear();
+
+        [[nodiscard]] size_t MemoryFootprint() const;
+
+    private:
+        // Merges the intervals added from position from on into the sorted disjoint ones before them,
+        // adjusting the element count by the part that changed
+        void Normalize(size_t from);
+
+        std::vector<Interval> intervals_;
+        uint64_t size_ = 0;
+};
+
+template<class F>
+bool IntRangeSet::ParseExpression(const std::string_view expression, F add) {
+    const char* pos = expression.data();
+    const char* end = expression.data() + expression.size();
+    if (pos == end)
+        return false;
+
+    for (;;) {
+        int first;
+        auto result = std::from_chars(pos, end, first);
+        if (result.ec != std::errc{})
+            return false;
+        pos = result.ptr;
+
+        int last = first;
+        if (pos != end && *pos == '-') {
+            result = std::from_chars(pos + 1, end, last);
+            if (result.ec != std::errc{} || last < first)
+                return false;
+            pos = result.ptr;
+        }
+        add(first, last);
+
+        if (pos == end)
+            return true;
+        if (*pos != ',')
+            return false;
+        ++pos;
+    }
+}
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_INT_RANGE_SET_H
@@ -0,0 +1,98 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_PERFECT_HASH_H
+#define ARG_PARSER_PAWKORCHAGIN_PERFECT_HASH_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace ArgumentParser {
+template<class E>
+struct EnumEntry {
+    std::string_view name;
+    E value;
+};
+
+namespace PerfectHashDetail {
+struct Params {
+    size_t size = 0;
+    uint64_t seed = 0;
+};
+
+constexpr uint64_t kSeedsPerSize = 256;
+
+constexpr uint64_t Hash(const std::string_view str, const uint64_t seed) {
+    uint64_t hash = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+    for (const char c: str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+template<const auto& Table>
+constexpr size_t MaxSize() {
+    return std::bit_ceil(Table.size() * Table.size() * 4 + 2);
+}
+
+template<const auto& Table>
+constexpr bool IsPerfect(const size_t size, const uint64_t seed) {
+    std::array<bool, MaxSize<Table>()> used{};
+    for (const auto& entry: Table) {
+        const size_t slot = Hash(entry.name, seed) & (size - 1);
+        if (used[slot])
+            return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+template<const auto& Table>
+constexpr Params FindParams() {
+    for (size_t size = std::bit_ceil(Table.size() * 2) ; size <= MaxSize<Table>() ; size *= 2) {
+        for (uint64_t seed = 0 ; seed < kSeedsPerSize ; ++seed) {
+            if (IsPerfect<Table>(size, seed))
+                return {size, seed};
+        }
+    }
+    return {};
+}
+
+template<const auto& Table, Params P>
+constexpr auto BuildSlots() {
+    std::array<size_t, P.size> slots{};
+    slots.fill(Table.size());
+    for (size_t i = 0 ; i < Table.size() ; ++i) {
+        slots[Hash(Table[i].name, P.seed) & (P.size - 1)] = i;
+    }
+    return slots;
+}
+} // namespace PerfectHashDetail
+
+// Collision free hash over the names of a constexpr table, e.g.
+// constexpr std::array<EnumEntry<Mode>, 2> kModes = {{{"fast", Mode::kFast}, {"safe", Mode::kSafe}}};
+// Seeds are tried at compile time, the slot table grows until one of them puts every name into its own slot
+template<const auto& Table>
+class PerfectHash {
+    public:
+        using Enum = std::remove_cvref_t<decltype(Table[0].value)>;
+
+        static constexpr size_t kNotFound = Table.size();
+
+        // Index of the entry with this name or kNotFound
+        static constexpr size_t Find(const std::string_view name) {
+            const size_t index = kSlots[PerfectHashDetail::Hash(name, kParams.seed) & (kParams.size - 1)];
+            return index != kNotFound && Table[index].name == name ? index : kNotFound;
+        }
+
+    private:
+        static constexpr PerfectHashDetail::Params kParams = PerfectHashDetail::FindParams<Table>();
+        static_assert(kParams.size != 0, "Enum names must be unique");
+        static constexpr auto kSlots = PerfectHashDetail::BuildSlots<Table, kParams>();
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_PERFECT_HASH_H
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_RING_BUFFER_H
+#define ARG_PARSER_PAWKORCHAGIN_RING_BUFFER_H
+
+#include <array>
+#include <cstddef>
+
+namespace ArgumentParser {
+// Fixed size buffer keeping the last Capacity pushed items, it never allocates
+template<class T, size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        void Push(const T& item) {
+            items_[pushed_ & (Capacity - 1)] = item;
+            ++pushed_;
+        }
+
+        void Clear() {
+            pushed_ = 0;
+        }
+
+        [[nodiscard]] size_t Size() const {
+            return pushed_ < Capacity ? pushed_ : Capacity;
+        }
+
+        // Items pushed before the kept ones were overwritten
+        [[nodiscard]] size_t Dropped() const {
+            return pushed_ - Size();
+        }
+
+        // i-th of the kept items, oldest first
+        [[nodiscard]] const T& operator[](const size_t i) const {
+            return items_[(Dropped() + i) & (Capacity - 1)];
+        }
+
+    private:
+        std::array<T, Capacity> items_{};
+        size_t pushed_ = 0;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_RING_BUFFER_H
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "shared_results.h"
+
+namespace {
+constexpr uint32_t kMagic = 0x31525041; // "APR1"
+constexpr uint32_t kVersion = 1;
+
+constexpr uint32_t kFlag = 0;
+constexpr uint32_t kInt = 1;
+constexpr uint32_t kString = 2;
+
+uint64_t WordsOf(const uint32_t type, const uint32_t count) {
+    return type == kString ? uint64_t{count} * 2 : count;
+}
+}
+
+namespace ArgumentParser {
+uint32_t SharedResults::Writer::AddFlag(const bool value) {
+    slots_.push_back({kFlag, 1, static_cast<uint32_t>(words_.size())});
+    words_.push_back(value);
+    return static_cast<uint32_t>(slots_.size() - 1);
+}
+
+uint32_t SharedResults::Writer::AddInts(const std::span<const int> values) {
+    slots_.push_back({kInt, static_cast<uint32_t>(values.size()), static_cast<uint32_t>(words_.size())});
+    for (const int value: values)
+        words_.push_back(static_cast<uint32_t>(value));
+    return static_cast<uint32_t>(slots_.size() - 1);
+}
+
+uint32_t SharedResults::Writer::AddStrings(const std::span<const std::string> values) {
+    slots_.push_back({kString, static_cast<uint32_t>(values.size()), static_cast<uint32_t>(words_.size())});
+    for (const auto& value: values) {
+        words_.push_back(static_cast<uint32_t>(chars_.size()));
+        words_.push_back(static_cast<uint32_t>(value.size()));
+        chars_ += value;
+    }
+    return static_cast<uint32_t>(slots_.size() - 1);
+}
+
+uint32_t SharedResults::Writer::AddString(const std::string_view value) {
+    slots_.push_back({kString, 1, static_cast<uint32_t>(words_.size())});
+    words_.push_back(static_cast<uint32_t>(chars_.size()));
+    words_.push_back(static_cast<uint32_t>(value.size()));
+    chars_ += value;
+    return static_cast<uint32_t>(slots_.size() - 1);
+}
+
+void SharedResults::Writer::AddName(const std::string_view name, const uint32_t slot) {
+    names_.emplace_back(name, slot);
+}
+
+int SharedResults::Writer::Export() const {
+#ifdef __linux__
+    auto names = names_;
+    std::ranges::sort(names);
+
+    std::string chars = chars_;
+    std::vector<Entry> entries;
+    entries.reserve(names.size());
+    for (const auto& [name, slot]: names) {
+        const Slot& value = slots_[slot];
+        entries.push_back({static_cast<uint32_t>(chars.size()), static_cast<uint32_t>(name.size()),
+                           value.type, value.count, value.offset});
+        chars += name;
+    }
+
+    const Header header{kMagic, kVersion, static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(words_.size()),
+                        static_cast<uint32_t>(chars.size())};
+    std::string buffer(sizeof(Header) + entries.size() * sizeof(Entry) + words_.size() * sizeof(uint32_t)
+                       + chars.size(), '\0');
+    char* out = buffer.data();
+    std::memcpy(out, &header, sizeof(Header));
+    out += sizeof(Header);
+    // An empty vector may have no storage, memcpy must not be given its null data()
+    if (!entries.empty())
+        std::memcpy(out, entries.data(), entries.size() * sizeof(Entry));
+    out += entries.size() * sizeof(Entry);
+    if (!words_.empty())
+        std::memcpy(out, words_.data(), words_.size() * sizeof(uint32_t));
+    out += words_.size() * sizeof(uint32_t);
+    std::memcpy(out, chars.data(), chars.size());
+
+    const int fd = memfd_create("arg-parser-results", MFD_ALLOW_SEALING);
+    if (fd == -1)
+        return -1;
+
+    for (size_t written = 0 ; written < buffer.size() ;) {
+        const ssize_t result = write(fd, buffer.data() + written, buffer.size() - written);
+        if (result <= 0) {
+            close(fd);
+            return -1;
+        }
+        written += static_cast<size_t>(result);
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+SharedResults::SharedResults(SharedResults&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      entries_(std::exchange(other.entries_, {})),
+      words_(std::exchange(other.words_, {})),
+      chars_(std::exchange(other.chars_, {})) {
+}
+
+SharedResults& SharedResults::operator=(SharedResults&& other) noexcept {
+    if (this != &other) {
+        Detach();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        entries_ = std::exchange(other.entries_, {});
+        words_ = std::exchange(other.words_, {});
+        chars_ = std::exchange(other.chars_, {});
+    }
+    return *this;
+}
+
+SharedResults::~SharedResults() {
+    Detach();
+}
+
+bool SharedResults::Attach(const int fd) {
+    Detach();
+#ifdef __linux__
+    struct stat info{};
+    if (fstat(fd, &info) == -1 || static_cast<size_t>(info.st_size) < sizeof(Header))
+        return false;
+
+    const auto size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+        return false;
+    data_ = static_cast<const std::byte*>(data);
+    size_ = size;
+
+    Header header;
+    std::memcpy(&header, data_, sizeof(Header));
+    if (header.magic != kMagic || header.version != kVersion
+        || sizeof(Header) + uint64_t{header.entries} * sizeof(Entry) + uint64_t{header.words} * sizeof(uint32_t)
+           + header.chars != size) {
+        Detach();
+        return false;
+    }
+
+    const std::byte* pos = data_ + sizeof(Header);
+    entries_ = std::span(reinterpret_cast<const Entry*>(pos), header.entries);
+    pos += header.entries * sizeof(Entry);
+    words_ = std::span(reinterpret_cast<const uint32_t*>(pos), header.words);
+    pos += header.words * sizeof(uint32_t);
+    chars_ = std::string_view(reinterpret_cast<const char*>(pos), header.chars);
+
+    // Everything is checked once here, so the getters can read without bounds checks
+    for (const Entry& entry: entries_) {
+        bool is_valid = entry.type <= kString
+                        && uint64_t{entry.name_offset} + entry.name_size <= chars_.size()
+                        && entry.offset + WordsOf(entry.type, entry.count) <= words_.size();
+        for (uint32_t i = 0 ; is_valid && entry.type == kString && i < entry.count ; ++i) {
+            const uint32_t offset = words_[entry.offset + 2 * i];
+            is_valid = uint64_t{offset} + words_[entry.offset + 2 * i + 1] <= chars_.size();
+        }
+        if (!is_valid) {
+            Detach();
+            return false;
+        }
+    }
+
+    return true;
+#else
+    (void) fd;
+    return false;
+#endif
+}
+
+bool SharedResults::Contains(const std::string_view name) const {
+    return Find(name) != nullptr;
+}
+
+size_t SharedResults::Count(const std::string_view name) const {
+    const Entry* entry = Find(name);
+    return entry != nullptr ? entry->count : 0;
+}
+
+int SharedResults::GetIntValue(const std::string_view name, const size_t index) const {
+    const std::span<const int> values = GetIntValues(name);
+    return index < values.size() ? values[index] : 0;
+}
+
+std::span<const int> SharedResults::GetIntValues(const std::string_view name) const {
+    const Entry* entry = Find(name, kInt);
+    if (entry == nullptr)
+        return {};
+    return std::span(reinterpret_cast<const int*>(words_.data() + entry->offset), entry->count);
+}
+
+bool SharedResults::GetFlag(const std::string_view name) const {
+    const Entry* entry = Find(name, kFlag);
+    return entry != nullptr && words_[entry->offset] != 0;
+}
+
+std::string_view SharedResults::GetStringValue(const std::string_view name, const size_t index) const {
+    const Entry* entry = Find(name, kString);
+    if (entry == nullptr || index >= entry->count)
+        return {};
+    return GetChars(words_[entry->offset + 2 * index], words_[entry->offset + 2 * index + 1]);
+}
+
+const SharedResults::Entry* SharedResults::Find(const std::string_view name) const {
+    const auto it = std::ranges::lower_bound(entries_, name, {}, [&](const Entry& entry) {
+        return GetChars(entry.name_offset, entry.name_size);
+    });
+    if (it == entries_.end() || GetChars(it->name_offset, it->name_size) != name)
+        return nullptr;
+    return &*it;
+}
+
+const SharedResults::Entry* SharedResults::Find(const std::string_view name, const uint32_t type) const {
+    const Entry* entry = Find(name);
+    return entry != nullptr && entry->type == type ? entry : nullptr;
+}
+
+std::string_view SharedResults::GetChars(const uint32_t offset, const uint32_t size) const {
+    return chars_.substr(offset, size);
+}
+
+void SharedResults::Detach() {
+#ifdef __linux__
+    if (data_ != nullptr)
+        munmap(const_cast<std::byte*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    entries_ = {};
+    words_ = {};
+    chars_ = {};
+}
+} // namespace ArgumentParser
@@ -0,0 +1,103 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_SHARED_RESULTS_H
+#define ARG_PARSER_PAWKORCHAGIN_SHARED_RESULTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+// Read only view of parse results exported by ArgParser::ExportResults into a memfd.
+// The segment is one flat buffer: a header, entries sorted by name, value words and characters,
+// so values are read in place without building a schema or parsing
+class SharedResults {
+    public:
+        // Collects values and the names referring to them, then writes them into a sealed memfd
+        class Writer {
+            public:
+                // Each returns the slot of the value, names are attached to slots with AddName
+                uint32_t AddFlag(bool value);
+                uint32_t AddInts(std::span<const int> values);
+                uint32_t AddStrings(std::span<const std::string> values);
+                uint32_t AddString(std::string_view value);
+
+                void AddName(std::string_view name, uint32_t slot);
+
+                // A read only memfd without FD_CLOEXEC, so an exec'ed worker inherits it. -1 on failure
+                [[nodiscard]] int Export() const;
+
+            private:
+                struct Slot {
+                    uint32_t type;
+                    uint32_t count;
+                    uint32_t offset; // in words
+                };
+
+                std::vector<Slot> slots_;
+                std::vector<std::pair<std::string_view, uint32_t>> names_;
+                std::vector<uint32_t> words_;
+                std::string chars_;
+        };
+
+        SharedResults() = default;
+
+        SharedResults(SharedResults&& other) noexcept;
+
+        SharedResults& operator=(SharedResults&& other) noexcept;
+
+        SharedResults(const SharedResults&) = delete;
+
+        SharedResults& operator=(const SharedResults&) = delete;
+
+        ~SharedResults();
+
+        // Maps the segment, false if fd does not hold well formed results. fd may be closed afterwards
+        bool Attach(int fd);
+
+        [[nodiscard]] bool Contains(std::string_view name) const;
+
+        // Number of values, 1 for flags and single value arguments, 0 for unknown names
+        [[nodiscard]] size_t Count(std::string_view name) const;
+
+        // Unknown names and type mismatches give 0, false and an empty string
+        [[nodiscard]] int GetIntValue(std::string_view name, size_t index = 0) const;
+        [[nodiscard]] std::span<const int> GetIntValues(std::string_view name) const;
+        [[nodiscard]] bool GetFlag(std::string_view name) const;
+        [[nodiscard]] std::string_view GetStringValue(std::string_view name, size_t index = 0) const;
+
+    private:
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entries;
+            uint32_t words;
+            uint32_t chars;
+        };
+
+        // Strings take two words per value: offset and size in the characters
+        struct Entry {
+            uint32_t name_offset;
+            uint32_t name_size;
+            uint32_t type;
+            uint32_t count;
+            uint32_t offset; // in words
+        };
+
+        [[nodiscard]] const Entry* Find(std::string_view name) const;
+        [[nodiscard]] const Entry* Find(std::string_view name, uint32_t type) const;
+        [[nodiscard]] std::string_view GetChars(uint32_t offset, uint32_t size) const;
+        void Detach();
+
+        const std::byte* data_ = nullptr;
+        size_t size_ = 0;
+        std::span<const Entry> entries_;
+        std::span<const uint32_t> words_;
+        std::string_view chars_;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_SHARED_RESULTS_H
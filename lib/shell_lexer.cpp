@@ -0,0 +1,113 @@
+#include <bit>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "shell_lexer.h"
+
+namespace {
+bool IsBlank(const char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+bool IsSpecial(const char c) {
+    return IsBlank(c) || c == '\'' || c == '"' || c == '\\';
+}
+
+// Position of the first blank, quote or backslash at or after pos, str.size() if there is none
+size_t FindSpecial(const std::string_view str, size_t pos) {
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i single_quote = _mm_set1_epi8('\'');
+    const __m128i double_quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    for (; pos + 16 <= str.size() ; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + pos));
+        const __m128i blanks = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                            _mm_cmpeq_epi8(chunk, newline));
+        const __m128i escapes = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, single_quote), _mm_cmpeq_epi8(chunk, double_quote)),
+            _mm_cmpeq_epi8(chunk, backslash));
+        if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(blanks, escapes))) ; mask != 0)
+            return pos + std::countr_zero(mask);
+    }
+#endif
+
+    while (pos < str.size() && !IsSpecial(str[pos]))
+        ++pos;
+    return pos;
+}
+}
+
+namespace ArgumentParser {
+bool ShellLexer::Split(const std::string_view command, std::vector<std::string_view>& tokens) {
+    tokens.clear();
+    buffer_.clear();
+    // Unescaping never makes the text longer, so views into the buffer are not moved by appends
+    buffer_.reserve(command.size());
+
+    size_t pos = 0;
+    for (;;) {
+        while (pos < command.size() && IsBlank(command[pos]))
+            ++pos;
+        if (pos == command.size())
+            return true;
+
+        const size_t begin = pos;
+        pos = FindSpecial(command, pos);
+        if (pos == command.size() || IsBlank(command[pos])) {
+            tokens.push_back(command.substr(begin, pos - begin));
+            continue;
+        }
+
+        // The token has quotes or backslashes, it is rebuilt in the buffer
+        const size_t start = buffer_.size();
+        buffer_.append(command, begin, pos - begin);
+        while (pos < command.size() && !IsBlank(command[pos])) {
+            const char c = command[pos];
+            if (c == '\'') {
+                const size_t end = command.find('\'', pos + 1);
+                if (end == std::string_view::npos)
+                    return false;
+                buffer_.append(command, pos + 1, end - pos - 1);
+                pos = end + 1;
+            } else if (c == '"') {
+                for (++pos ; pos < command.size() && command[pos] != '"' ; ++pos) {
+                    if (command[pos] == '\\' && pos + 1 < command.size()) {
+                        const char next = command[pos + 1];
+                        if (next == '\n') {
+                            ++pos;
+                            continue;
+                        }
+                        if (next == '$' || next == '`' || next == '"' || next == '\\')
+                            ++pos;
+                    }
+                    buffer_ += command[pos];
+                }
+                if (pos == command.size())
+                    return false;
+                ++pos;
+            } else if (c == '\\') {
+                if (pos + 1 < command.size()) {
+                    if (command[pos + 1] != '\n')
+                        buffer_ += command[pos + 1];
+                    pos += 2;
+                } else {
+                    buffer_ += c;
+                    ++pos;
+                }
+            } else {
+                const size_t end = FindSpecial(command, pos);
+                buffer_.append(command, pos, end - pos);
+                pos = end;
+            }
+        }
+        tokens.push_back(std::string_view(buffer_).substr(start));
+    }
+}
+} // namespace ArgumentParser
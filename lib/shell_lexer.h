@@ -0,0 +1,26 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_SHELL_LEXER_H
+#define ARG_PARSER_PAWKORCHAGIN_SHELL_LEXER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+// Splits a command string the way a POSIX shell splits words: blanks separate tokens,
+// 'single quotes' keep everything, "double quotes" let a backslash escape $ ` " \ and newline,
+// a backslash outside quotes escapes any char. No expansions are done.
+// Tokens without quotes or backslashes are views into the command, the others are unescaped into
+// a buffer owned by the lexer, all of them stay valid until the next Split
+class ShellLexer {
+    public:
+        // False if a quote is not closed
+        bool Split(std::string_view command, std::vector<std::string_view>& tokens);
+
+    private:
+        std::string buffer_;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_SHELL_LEXER_H
@@ -0,0 +1,121 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_SMALL_FUNCTION_H
+#define ARG_PARSER_PAWKORCHAGIN_SMALL_FUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ArgumentParser {
+template<class Signature, size_t Capacity = 3 * sizeof(void*)>
+class SmallFunction;
+
+// Move only std::function replacement: callables up to Capacity bytes live inside the object,
+// only bigger ones are put on the heap
+template<class R, class... Args, size_t Capacity>
+class SmallFunction<R(Args...), Capacity> {
+    public:
+        SmallFunction() = default;
+
+        template<class F> requires (!std::is_same_v<std::decay_t<F>, SmallFunction>
+                                    && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+        SmallFunction(F&& function) {
+            using T = std::decay_t<F>;
+            if constexpr (kIsInline<T>) {
+                ::new(static_cast<void*>(buffer_)) T(std::forward<F>(function));
+                ops_ = &kInlineOps<T>;
+            } else {
+                ::new(static_cast<void*>(buffer_)) T*(new T(std::forward<F>(function)));
+                ops_ = &kHeapOps<T>;
+            }
+        }
+
+        SmallFunction(SmallFunction&& other) noexcept : ops_(other.ops_) {
+            if (ops_ != nullptr) {
+                ops_->move(other.buffer_, buffer_);
+                other.ops_ = nullptr;
+            }
+        }
+
+        SmallFunction& operator=(SmallFunction&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                ops_ = other.ops_;
+                if (ops_ != nullptr) {
+                    ops_->move(other.buffer_, buffer_);
+                    other.ops_ = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        SmallFunction(const SmallFunction&) = delete;
+
+        SmallFunction& operator=(const SmallFunction&) = delete;
+
+        ~SmallFunction() {
+            Reset();
+        }
+
+        R operator()(Args... args) {
+            return ops_->invoke(buffer_, std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const {
+            return ops_ != nullptr;
+        }
+
+    private:
+        struct Ops {
+            R (*invoke)(void*, Args&&...);
+            void (*move)(void* from, void* to) noexcept;
+            void (*destroy)(void*) noexcept;
+        };
+
+        template<class T>
+        static constexpr bool kIsInline = sizeof(T) <= Capacity && alignof(T) <= alignof(std::max_align_t)
+                                          && std::is_nothrow_move_constructible_v<T>;
+
+        template<class T>
+        static constexpr Ops kInlineOps = {
+            [](void* buffer, Args&&... args) -> R {
+                return (*std::launder(static_cast<T*>(buffer)))(std::forward<Args>(args)...);
+            },
+            [](void* from, void* to) noexcept {
+                T* source = std::launder(static_cast<T*>(from));
+                ::new(to) T(std::move(*source));
+                source->~T();
+            },
+            [](void* buffer) noexcept {
+                std::launder(static_cast<T*>(buffer))->~T();
+            },
+        };
+
+        template<class T>
+        static constexpr Ops kHeapOps = {
+            [](void* buffer, Args&&... args) -> R {
+                return (**std::launder(static_cast<T**>(buffer)))(std::forward<Args>(args)...);
+            },
+            [](void* from, void* to) noexcept {
+                ::new(to) T*(*std::launder(static_cast<T**>(from)));
+            },
+            [](void* buffer) noexcept {
+                delete *std::launder(static_cast<T**>(buffer));
+            },
+        };
+
+        void Reset() {
+            if (ops_ != nullptr) {
+                ops_->destroy(buffer_);
+                ops_ = nullptr;
+            }
+        }
+
+        alignas(std::max_align_t) unsigned char buffer_[Capacity];
+        const Ops* ops_ = nullptr;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_SMALL_FUNCTION_H
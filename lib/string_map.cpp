@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <utility>
+
+#include "string_map.h"
+
+namespace ArgumentParser {
+bool StringMap::Insert(const std::string_view key, const std::string_view value, const bool replace) {
+    if ((size_ + 1) * 2 > slots_.size())
+        Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+
+    Slot& slot = slots_[FindSlot(key)];
+    if (slot.is_used) {
+        if (replace)
+            Replace(slot.value, value);
+        return false;
+    }
+
+    slot = {Append(key), Append(value), true};
+    ++size_;
+    return true;
+}
+
+bool StringMap::Contains(const std::string_view key) const {
+    return !slots_.empty() && slots_[FindSlot(key)].is_used;
+}
+
+std::string_view StringMap::Get(const std::string_view key) const {
+    if (slots_.empty())
+        return {};
+
+    const Slot& slot = slots_[FindSlot(key)];
+    return slot.is_used ? View(slot.value) : std::string_view();
+}
+
+size_t StringMap::Size() const {
+    return size_;
+}
+
+void StringMap::Reserve(const size_t count) {
+    if ((size_ + count) * 2 > slots_.size())
+        Rehash(std::bit_ceil(std::max<size_t>((size_ + count) * 2, 16)));
+}
+
+void StringMap::Clear() {
+    chars_.clear();
+    unused_ = 0;
+    slots_.clear();
+    size_ = 0;
+}
+
+size_t StringMap::MemoryFootprint() const {
+    return chars_.capacity() + slots_.capacity() * sizeof(Slot);
+}
+
+std::string_view StringMap::View(const Ref ref) const {
+    return std::string_view(chars_).substr(ref.offset, ref.size);
+}
+
+StringMap::Ref StringMap::Append(const std::string_view str) {
+    const Ref ref{static_cast<uint32_t>(chars_.size()), static_cast<uint32_t>(str.size())};
+    chars_ += str;
+    return ref;
+}
+
+// Last wins replaces of one key must not grow the buffer without limit
+void StringMap::Replace(Ref& ref, const std::string_view value) {
+    if (value.size() <= ref.size) {
+        chars_.replace(ref.offset, value.size(), value);
+        unused_ += ref.size - value.size();
+        ref.size = static_cast<uint32_t>(value.size());
+        return;
+    }
+
+    unused_ += ref.size;
+    ref = Append(value);
+    if (unused_ * 2 > chars_.size())
+        Compact();
+}
+
+void StringMap::Compact() {
+    std::string chars;
+    chars.reserve(chars_.size() - unused_);
+    for (auto& slot: slots_) {
+        if (!slot.is_used)
+            continue;
+        for (Ref* ref: {&slot.key, &slot.value}) {
+            const std::string_view str = View(*ref);
+            ref->offset = static_cast<uint32_t>(chars.size());
+            chars += str;
+        }
+    }
+    chars_ = std::move(chars);
+    unused_ = 0;
+}
+
+// Slot holding the key or the empty slot where it would go
+size_t StringMap::FindSlot(const std::string_view key) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = std::hash<std::string_view>{}(key) & mask ;; slot = (slot + 1) & mask) {
+        if (!slots_[slot].is_used || View(slots_[slot].key) == key)
+            return slot;
+    }
+}
+
+void StringMap::Rehash(const size_t slots) {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(slots, Slot{});
+
+    for (const auto& slot: old) {
+        if (slot.is_used)
+            slots_[FindSlot(View(slot.key))] = slot;
+    }
+}
+} // namespace ArgumentParser
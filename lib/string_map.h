@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_STRING_MAP_H
+#define ARG_PARSER_PAWKORCHAGIN_STRING_MAP_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+// Open addressing map from string to string, both kept back to back in one buffer. A replaced value is
+// overwritten in place when the new one fits, otherwise its bytes are reclaimed once they are half the buffer.
+// Views returned by Get and ForEach stay valid until the next Insert or Clear
+class StringMap {
+    public:
+        // Adds the pair, an existing key gets the new value if replace is set. False if the key was present
+        bool Insert(std::string_view key, std::string_view value, bool replace);
+
+        [[nodiscard]] bool Contains(std::string_view key) const;
+
+        // Empty view if there is no such key
+        [[nodiscard]] std::string_view Get(std::string_view key) const;
+
+        [[nodiscard]] size_t Size() const;
+
+        // Makes room for count more keys without rehashing
+        void Reserve(size_t count);
+
+        void Clear();
+
+        // Calls function(key, value) for every pair, in no particular order
+        template<class F>
+        void ForEach(F function) const {
+            for (const auto& slot: slots_) {
+                if (slot.is_used)
+                    function(View(slot.key), View(slot.value));
+            }
+        }
+
+        [[nodiscard]] size_t MemoryFootprint() const;
+
+    private:
+        struct Ref {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+        };
+
+        struct Slot {
+            Ref key;
+            Ref value;
+            bool is_used = false;
+        };
+
+        [[nodiscard]] std::string_view View(Ref ref) const;
+        Ref Append(std::string_view str);
+        void Replace(Ref& ref, std::string_view value);
+        void Compact();
+        [[nodiscard]] size_t FindSlot(std::string_view key) const;
+        void Rehash(size_t slots);
+
+        std::string chars_;
+        size_t unused_ = 0; // bytes of replaced values still in chars_
+        std::vector<Slot> slots_;
+        size_t size_ = 0;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_STRING_MAP_H
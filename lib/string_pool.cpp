@@ -0,0 +1,103 @@
+#include <functional>
+
+#include "string_pool.h"
+
+namespace ArgumentParser {
+StringPool::Ref StringPool::Add(const std::string_view str) {
+    if (str.empty())
+        return {};
+    if ((size_ + 1) * 2 > slots_.size())
+        Grow();
+
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = std::hash<std::string_view>{}(str) & mask ;; slot = (slot + 1) & mask) {
+        if (slots_[slot].size == 0) {
+            slots_[slot] = {static_cast<uint32_t>(data_.size()), static_cast<uint32_t>(str.size())};
+            ++size_;
+            data_ += str;
+            return slots_[slot];
+        }
+        if (View(slots_[slot]) == str)
+            return slots_[slot];
+    }
+}
+
+std::string_view StringPool::View(const Ref ref) const {
+    return std::string_view(data_).substr(ref.offset, ref.size);
+}
+
+std::string_view StringPool::Translate(const std::string_view str, const StringPool& copy) const {
+    const std::less_equal<const char*> less_equal;
+    if (!less_equal(data_.data(), str.data()) || !less_equal(str.data() + str.size(), data_.data() + data_.size()))
+        return str;
+
+    return std::string_view(copy.data_).substr(str.data() - data_.data(), str.size());
+}
+
+void StringPool::Clear() {
+    data_.clear();
+    slots_.clear();
+    size_ = 0;
+}
+
+size_t StringPool::MemoryFootprint() const {
+    return data_.capacity() + slots_.capacity() * sizeof(Ref);
+}
+
+void StringPool::Grow() {
+    std::vector<Ref> old = std::move(slots_);
+    slots_.assign(old.empty() ? 16 : old.size() * 2, Ref{});
+
+    const size_t mask = slots_.size() - 1;
+    for (const auto& ref: old) {
+        if (ref.size == 0)
+            continue;
+        size_t slot = std::hash<std::string_view>{}(View(ref)) & mask;
+        while (slots_[slot].size != 0)
+            slot = (slot + 1) & mask;
+        slots_[slot] = ref;
+    }
+}
+
+void NameIndex::Insert(const StringPool& pool, const StringPool::Ref ref, const uint32_t id) {
+    if ((size_ + 1) * 2 > slots_.size())
+        Grow(pool);
+
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = std::hash<std::string_view>{}(pool.View(ref)) & mask ;; slot = (slot + 1) & mask) {
+        if (slots_[slot].id == kNone) {
+            slots_[slot] = {ref, id};
+            ++size_;
+            return;
+        }
+        if (pool.View(slots_[slot].ref) == pool.View(ref))
+            return;
+    }
+}
+
+uint32_t NameIndex::Find(const StringPool& pool, const std::string_view str) const {
+    if (slots_.empty())
+        return kNone;
+
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = std::hash<std::string_view>{}(str) & mask ;; slot = (slot + 1) & mask) {
+        if (slots_[slot].id == kNone || pool.View(slots_[slot].ref) == str)
+            return slots_[slot].id;
+    }
+}
+
+size_t NameIndex::MemoryFootprint() const {
+    return slots_.capacity() * sizeof(Slot);
+}
+
+void NameIndex::Grow(const StringPool& pool) {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(old.empty() ? 16 : old.size() * 2, Slot{});
+    size_ = 0;
+
+    for (const auto& slot: old) {
+        if (slot.id != kNone)
+            Insert(pool, slot.ref, slot.id);
+    }
+}
+} // namespace ArgumentParser
@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_STRING_POOL_H
+#define ARG_PARSER_PAWKORCHAGIN_STRING_POOL_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+// All names, keys and descriptions of a parser live back to back in one buffer, each distinct string once
+class StringPool {
+    public:
+        struct Ref {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+        };
+
+        // Returns the Ref of an equal string added before, if there is one
+        Ref Add(std::string_view str);
+
+        [[nodiscard]] std::string_view View(Ref ref) const;
+
+        // The same characters in a copy of this pool, views from elsewhere are returned as is
+        [[nodiscard]] std::string_view Translate(std::string_view str, const StringPool& copy) const;
+
+        void Clear();
+
+        [[nodiscard]] size_t MemoryFootprint() const;
+
+    private:
+        void Grow();
+
+        std::string data_;
+        std::vector<Ref> slots_; // open addressing set of the added strings, a slot with size 0 is free
+        size_t size_ = 0;
+};
+
+// Open addressing map from pooled strings to dense argument ids
+class NameIndex {
+    public:
+        static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+        void Insert(const StringPool& pool, StringPool::Ref ref, uint32_t id);
+
+        [[nodiscard]] uint32_t Find(const StringPool& pool, std::string_view str) const;
+
+        // Calls function(ref, id) for every inserted string, in no particular order
+        template<class F>
+        void ForEach(F function) const {
+            for (const auto& slot: slots_) {
+                if (slot.id != kNone)
+                    function(slot.ref, slot.id);
+            }
+        }
+
+        [[nodiscard]] size_t MemoryFootprint() const;
+
+    private:
+        struct Slot {
+            StringPool::Ref ref;
+            uint32_t id = kNone;
+        };
+
+        void Grow(const StringPool& pool);
+
+        std::vector<Slot> slots_;
+        size_t size_ = 0;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_STRING_POOL_H
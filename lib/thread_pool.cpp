@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <latch>
+
+#include "thread_pool.h"
+
+namespace ArgumentParser {
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    workers_.reserve(threads - 1);
+    for (size_t i = 1 ; i < threads ; ++i) {
+        workers_.emplace_back([this] { Work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        is_stopped_ = true;
+    }
+    has_task_.notify_all();
+    for (auto& worker: workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push(std::move(task));
+    }
+    has_task_.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock lock(mutex_);
+    is_idle_.wait(lock, [this] { return tasks_.empty() && active_ == 0; });
+}
+
+void ThreadPool::ParallelFor(const size_t count,
+                             const size_t grain,
+                             const std::function<void(size_t, size_t)>& body) {
+    const size_t step = std::max<size_t>(grain, 1);
+    const size_t helpers = std::min(workers_.size(), (count + step - 1) / step);
+    std::atomic<size_t> next = 0;
+
+    auto run = [&] {
+        for (size_t begin = next.fetch_add(step) ; begin < count ; begin = next.fetch_add(step)) {
+            body(begin, std::min(begin + step, count));
+        }
+    };
+
+    std::latch done(static_cast<std::ptrdiff_t>(helpers));
+    for (size_t i = 0 ; i < helpers ; ++i) {
+        Submit([&] {
+            run();
+            done.count_down();
+        });
+    }
+    run();
+    done.wait();
+}
+
+size_t ThreadPool::Size() const {
+    return workers_.size() + 1;
+}
+
+void ThreadPool::Work() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            has_task_.wait(lock, [this] { return is_stopped_ || !tasks_.empty(); });
+            if (is_stopped_ && tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+            ++active_;
+        }
+
+        task();
+
+        {
+            std::lock_guard lock(mutex_);
+            --active_;
+        }
+        is_idle_.notify_all();
+    }
+}
+} // namespace ArgumentParser
@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_THREAD_POOL_H
+#define ARG_PARSER_PAWKORCHAGIN_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace ArgumentParser {
+class ThreadPool {
+    public:
+        // threads = 0 means one worker per hardware thread (the caller of ParallelFor is counted)
+        explicit ThreadPool(size_t threads = 0);
+
+        ThreadPool(const ThreadPool&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool();
+
+        void Submit(std::function<void()> task);
+
+        void Wait();
+
+        // Calls body(begin, end) for chunks of [0, count), chunks are taken dynamically by workers and the caller
+        void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+        [[nodiscard]] size_t Size() const;
+
+    private:
+        void Work();
+
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable has_task_;
+        std::condition_variable is_idle_;
+        size_t active_ = 0;
+        bool is_stopped_ = false;
+};
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_THREAD_POOL_H
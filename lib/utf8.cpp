@@ -0,0 +1,191 @@
+#include <bit>
+#include <cstdint>
+
+#ifdef __SSSE3__
+#include <cstring>
+#include <initializer_list>
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "utf8.h"
+
+namespace {
+#ifdef __SSSE3__
+// Keiser and Lemire, "Validating UTF-8 in less than one instruction per byte": every error shows up in the
+// high nibble of a byte, the low nibble of the byte before it and the high nibble of the byte itself
+constexpr uint8_t kTooShort = 1 << 0; // a lead byte not followed by a continuation
+constexpr uint8_t kTooLong = 1 << 1; // a continuation after ASCII
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoContinuations = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoContinuations;
+
+__m128i Table(const std::initializer_list<uint8_t> bytes) {
+    alignas(16) uint8_t table[16];
+    std::memcpy(table, bytes.begin(), sizeof(table));
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+__m128i HighNibbles(const __m128i bytes) {
+    return _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F));
+}
+
+// Errors of every byte given the byte before it, two and three byte sequences are finished below
+__m128i SpecialCases(const __m128i input, const __m128i prev1) {
+    static const __m128i kByte1High = Table({
+        // 0___ ASCII
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        // 10__ continuation
+        kTwoContinuations, kTwoContinuations, kTwoContinuations, kTwoContinuations,
+        // 1100, 1101 two byte lead
+        kTooShort | kOverlong2, kTooShort,
+        // 1110 three byte lead, 1111 four byte lead
+        kTooShort | kOverlong3 | kSurrogate, kTooShort | kTooLarge | kTooLarge1000 | kOverlong4
+    });
+    static const __m128i kByte1Low = Table({
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4, kCarry | kOverlong2, kCarry, kCarry,
+        kCarry | kTooLarge, kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000
+    });
+    static const __m128i kByte2High = Table({
+        // 0___ ASCII
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        // 1000, 1001, 101_ continuation
+        kTooLong | kOverlong2 | kTwoContinuations | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoContinuations | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoContinuations | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoContinuations | kSurrogate | kTooLarge,
+        // 11__ lead
+        kTooShort, kTooShort, kTooShort, kTooShort
+    });
+
+    const __m128i byte_1_high = _mm_shuffle_epi8(kByte1High, HighNibbles(prev1));
+    const __m128i byte_1_low = _mm_shuffle_epi8(kByte1Low, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+    const __m128i byte_2_high = _mm_shuffle_epi8(kByte2High, HighNibbles(input));
+    return _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+}
+
+// Errors of the block, prev is the block before it. A continuation that is the third or fourth byte of a
+// sequence cancels the kTwoContinuations flag, everywhere else the flag is an error
+__m128i CheckMultiByte(const __m128i input, const __m128i prev) {
+    const __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    const __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+    const __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+    const __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    const __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    const __m128i must_be_continuation = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte),
+                                                       _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must_be_continuation, SpecialCases(input, prev1));
+}
+
+// Non zero if the block ends inside a sequence, an error unless the next block finishes it
+__m128i IsIncomplete(const __m128i input) {
+    static const __m128i kMaxValue = Table({
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+    });
+    return _mm_subs_epu8(input, kMaxValue);
+}
+#else
+bool IsContinuation(const uint8_t byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+// Position after the ASCII run starting at pos
+size_t SkipAscii(const std::string_view str, size_t pos) {
+#ifdef __SSE2__
+    for (; pos + 16 <= str.size() ; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + pos));
+        if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(chunk)) ; mask != 0)
+            return pos + std::countr_zero(mask);
+    }
+#endif
+
+    while (pos < str.size() && static_cast<uint8_t>(str[pos]) < 0x80)
+        ++pos;
+    return pos;
+}
+
+// Length of the well formed sequence at pos, 0 if there is none (Unicode Table 3-7)
+size_t SequenceLength(const std::string_view str, const size_t pos) {
+    const auto byte = [&](const size_t i) {
+        return pos + i < str.size() ? static_cast<uint8_t>(str[pos + i]) : uint8_t{0};
+    };
+
+    const uint8_t lead = byte(0);
+    if (lead < 0x80)
+        return 1;
+    if (lead < 0xC2)
+        return 0; // continuation byte or overlong two byte form
+    if (lead < 0xE0)
+        return IsContinuation(byte(1)) ? 2 : 0;
+
+    const uint8_t second = byte(1);
+    if (lead < 0xF0) {
+        const bool is_second_valid = lead == 0xE0   ? second >= 0xA0 && second <= 0xBF
+                                     : lead == 0xED ? second >= 0x80 && second <= 0x9F
+                                                    : IsContinuation(second);
+        return is_second_valid && IsContinuation(byte(2)) ? 3 : 0;
+    }
+    if (lead < 0xF5) {
+        const bool is_second_valid = lead == 0xF0   ? second >= 0x90 && second <= 0xBF
+                                     : lead == 0xF4 ? second >= 0x80 && second <= 0x8F
+                                                    : IsContinuation(second);
+        return is_second_valid && IsContinuation(byte(2)) && IsContinuation(byte(3)) ? 4 : 0;
+    }
+
+    return 0;
+}
+#endif
+}
+
+namespace ArgumentParser {
+bool IsValidUtf8(const std::string_view str) {
+#ifdef __SSSE3__
+    __m128i error = _mm_setzero_si128();
+    __m128i prev = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    const auto check = [&](const __m128i input) {
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, prev_incomplete);
+            prev_incomplete = _mm_setzero_si128();
+        } else {
+            error = _mm_or_si128(error, CheckMultiByte(input, prev));
+            prev_incomplete = IsIncomplete(input);
+        }
+        prev = input;
+    };
+
+    size_t pos = 0;
+    for (; pos + 16 <= str.size() ; pos += 16)
+        check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + pos)));
+    if (pos < str.size()) {
+        // The tail is padded with ASCII zeros
+        alignas(16) char tail[16] = {};
+        std::memcpy(tail, str.data() + pos, str.size() - pos);
+        check(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)));
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+#else
+    size_t pos = SkipAscii(str, 0);
+    while (pos < str.size()) {
+        const size_t length = SequenceLength(str, pos);
+        if (length == 0)
+            return false;
+        pos = SkipAscii(str, pos + length);
+    }
+
+    return true;
+#endif
+}
+} // namespace ArgumentParser
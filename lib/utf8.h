@@ -0,0 +1,15 @@
+#pragma once
+
+#ifndef ARG_PARSER_PAWKORCHAGIN_UTF8_H
+#define ARG_PARSER_PAWKORCHAGIN_UTF8_H
+
+#include <string_view>
+
+namespace ArgumentParser {
+// True if str is well formed UTF-8: no overlong forms, no surrogates, nothing above U+10FFFF.
+// With SSSE3 every 16 byte block is checked with nibble lookup tables, otherwise ASCII runs are skipped
+// 16 bytes at a time with SSE2 and the other sequences are decoded one by one
+[[nodiscard]] bool IsValidUtf8(std::string_view str);
+} // namespace ArgumentParser
+
+#endif // ARG_PARSER_PAWKORCHAGIN_UTF8_H
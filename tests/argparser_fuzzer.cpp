@@ -0,0 +1,39 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "arg_parser.h"
+
+using namespace ArgumentParser;
+
+// libFuzzer entry point: the input is a '\0' separated command line parsed against a fixed schema,
+// then the same bytes are parsed as one shell quoted command string
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size) {
+    std::vector<std::string> args = {"app"};
+    args.emplace_back();
+    for (size_t i = 0 ; i < size ; ++i) {
+        if (data[i] == '\0') {
+            args.emplace_back();
+        } else {
+            args.back() += static_cast<char>(data[i]);
+        }
+    }
+
+    int number;
+    bool flag;
+    std::vector<int> values;
+    std::string text;
+
+    ArgParser parser("Fuzzer");
+    parser.AddFlag("-a", "--flag1", "flag1");
+    parser.AddFlag("-b", "--flag2", "flag2").Default(true).StoreValue(flag);
+    parser.AddIntArgument("-n", "--number", "number").Default(0).StoreValue(number);
+    parser.AddIntArgument("--N").MultiValue().Positional().StoreValues(values);
+    parser.AddStringArgument("-s", "--string", "string").Default("").StoreValue(text);
+    parser.AddHelp("Fuzzer schema");
+    parser.Parse(args);
+    parser.ParseCommandLine(std::string_view(reinterpret_cast<const char*>(data), size));
+
+    return 0;
+}
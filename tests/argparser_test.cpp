@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <unistd.h>
 
 #include "arg_parser.h"
+#include "glob.h"
+#include "utf8.h"
 
 using namespace ArgumentParser;
 
@@ -11,6 +16,16 @@ std::vector<std::string> SplitString(const std::string& str) {
     return {std::istream_iterator<std::string>(iss), std::istream_iterator<std::string>()};
 }
 
+enum class Mode {
+    kFast, kSafe, kDebug
+};
+
+constexpr std::array<EnumEntry<Mode>, 3> kModes = {{
+    {"fast", Mode::kFast},
+    {"safe", Mode::kSafe},
+    {"debug", Mode::kDebug},
+}};
+
 TEST(ArgParserTestSuite, EmptyTest) {
     ArgParser parser("My Empty Parser");
 
@@ -105,6 +120,58 @@ TEST(ArgParserTestSuite, IntTest) {
     ASSERT_EQ(parser.GetIntValue("--param1"), 100500);
 }
 
+TEST(ArgParserTestSuite, ValidatorsTest) {
+    ArgParser parser("My Parser");
+    int threads;
+    std::string mode;
+    std::string label;
+    parser.AddIntArgument("-t", "--threads", "").Range(1, 64).StoreValue(threads);
+    parser.AddStringArgument("--mode").Choices({"fast", "safe", "debug"}).StoreValue(mode);
+    parser.AddStringArgument("--label").Matches("[a-z]+-[0-9]+").StoreValue(label);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -t 8 --mode=safe --label=job-42")));
+    ASSERT_EQ(threads, 8);
+    ASSERT_EQ(mode, "safe");
+    ASSERT_EQ(label, "job-42");
+    ASSERT_FALSE(parser.Parse(SplitString("app --threads=65 --mode=safe --label=job-42")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --threads=2 --mode=slow --label=job-42")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --threads=2 --mode=fast --label=job")));
+}
+
+TEST(ArgParserTestSuite, PositionalChoicesTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> values;
+    parser.AddIntArgument("--N").MultiValue().Positional().Choices({1, 2, 3}).StoreValues(values);
+    parser.Parallel(2);
+
+    std::vector<std::string> args = {"app"};
+    for (int i = 0 ; i < 10000 ; ++i)
+        args.push_back(std::to_string(i % 3 + 1));
+
+    ASSERT_TRUE(parser.Parse(args));
+    ASSERT_EQ(values.size(), 10000);
+    args[7000] = "4";
+    ASSERT_FALSE(parser.Parse(args));
+}
+
+TEST(ArgParserTestSuite, EnumTest) {
+    ArgParser parser("My Parser");
+    Mode mode;
+    parser.AddEnumArgument<kModes>("-m", "--mode", "").StoreValue(mode);
+    parser.AddEnumArgument<kModes>("--log-mode").Default(Mode::kSafe);
+    parser.AddHelp("Some Description about program");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -m debug")));
+    ASSERT_EQ(mode, Mode::kDebug);
+    ASSERT_EQ(parser.GetEnumValue<Mode>("--log-mode"), Mode::kSafe);
+    ASSERT_TRUE(parser.Parse(SplitString("app --mode=fast --log-mode debug")));
+    ASSERT_EQ(mode, Mode::kFast);
+    ASSERT_EQ(parser.GetEnumValue<Mode>("--log-mode"), Mode::kDebug);
+    ASSERT_NE(parser.HelpDescription().find("[default = safe]"), std::string::npos);
+    ASSERT_FALSE(parser.Parse(SplitString("app --mode=fas")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --mode=fastest")));
+}
+
 TEST(ArgParserTestSuite, MultiValueTest) {
     ArgParser parser("My Parser");
     std::vector<int> int_values;
@@ -123,14 +190,29 @@ TEST(ArgParserTestSuite, SameArgmentsTest) {
     ASSERT_FALSE(parser.Parse(SplitString("app --param1")));
 }
 
-// TEST(ArgParserTestSuite, MinCountMultiValueTest) {
-//     ArgParser parser("My Parser");
-//     std::vector<int> int_values;
-//     size_t min_args_count = 10;
-//     parser.AddIntArgument('p', "param1").MultiValue(min_args_count).StoreValues(int_values);
-//
-//     ASSERT_FALSE(parser.Parse(SplitString("app --param1=1 --param1=2 --param1=3")));
-// }
+TEST(ArgParserTestSuite, MinCountMultiValueTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> int_values;
+    size_t min_args_count = 10;
+    parser.AddIntArgument("-p", "--param1", "").MultiValue(min_args_count).StoreValues(int_values);
+
+    ASSERT_FALSE(parser.Parse(SplitString("app --param1=1 --param1=2 --param1=3")));
+}
+
+TEST(ArgParserTestSuite, MaxCountMultiValueTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> int_values;
+    std::vector<std::string> str_values;
+    parser.AddIntArgument("--N").MultiValue(2, 3).Positional().StoreValues(int_values);
+    parser.AddStringArgument("-s", "--str", "").MultiValue(0, 1).StoreValues(str_values);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 2 3 -s a")));
+    ASSERT_EQ(int_values.size(), 3);
+    ASSERT_GE(int_values.capacity(), 3);
+    ASSERT_FALSE(parser.Parse(SplitString("app 1 2 3 4")));
+    ASSERT_FALSE(parser.Parse(SplitString("app 1")));
+    ASSERT_FALSE(parser.Parse(SplitString("app 1 2 -s a --str=b")));
+}
 
 TEST(ArgParserTestSuite, FlagTest) {
     ArgParser parser("My Parser");
@@ -189,6 +271,14 @@ TEST(ArgParserTestSuite, WrongArgumentTest) {
     ASSERT_FALSE(parser.Parse(SplitString("app --exist? no")));
 }
 
+TEST(ArgParserTestSuite, EmptyTokenTest) {
+    ArgParser parser("My parser");
+    parser.AddStringArgument("--param1").Default("value1");
+    parser.AddFlag("-a", "--flag1", "").Default(false);
+    ASSERT_FALSE(parser.Parse(std::vector<std::string>{"app", ""}));
+    ASSERT_FALSE(parser.Parse(std::vector<std::string>{"app", "-a", "-"}));
+}
+
 TEST(ArgParserTestSuite, PostionalArgTest) {
     ArgParser parser("My Parser");
     int value;
@@ -209,6 +299,701 @@ TEST(ArgParserTestSuite, PositionalMultiValueArgTest) {
     ASSERT_EQ(values.size(), 5);
 }
 
+TEST(ArgParserTestSuite, ParallelPositionalTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> values;
+    std::vector<std::string> words;
+    bool sum;
+    size_t in_order = 0;
+    parser.AddIntArgument("--N").MultiValue().Positional().StoreValues(values).Action([&](const int value) {
+        // Called per value right after it is stored, also inside a parallel run
+        in_order += values.size() == in_order + 1 && values.back() == value;
+    });
+    parser.AddStringArgument("--word").MultiValue().Positional().StoreValues(words);
+    parser.AddFlag("-s", "--sum", "").StoreValue(sum);
+    parser.Parallel(4);
+
+    std::vector<std::string> args = {"app"};
+    for (int i = 0 ; i < 100000 ; ++i) {
+        args.push_back(i % 1000 == 999 ? "w" + std::to_string(i) : std::to_string(i));
+        if (i == 50000)
+            args.emplace_back("--sum");
+    }
+
+    ASSERT_TRUE(parser.Parse(args));
+    ASSERT_TRUE(sum);
+    ASSERT_EQ(values.size(), 99900);
+    ASSERT_EQ(words.size(), 100);
+    ASSERT_EQ(values[0], 0);
+    ASSERT_EQ(values[999], 1000);
+    ASSERT_EQ(values.back(), 99998);
+    ASSERT_EQ(words[0], "w999");
+    ASSERT_EQ(words.back(), "w99999");
+    ASSERT_EQ(in_order, 99900);
+}
+
+TEST(ArgParserTestSuite, EventsTest) {
+    ArgParser parser("My Parser");
+    int number = 0;
+    parser.AddIntArgument("-n", "--number", "").StoreValue(number);
+    parser.AddFlag("-a", "--flag1", "").Default(false);
+    parser.AddFlag("-b", "--flag2", "").Default(false);
+    parser.AddIntArgument("--input").MultiValue().Positional();
+
+    const auto args = SplitString("app -n 5 10 -ab 20 --number=7");
+    std::vector<std::pair<ParseEventKind, std::string>> events;
+    for (const auto& event: parser.Events(args)) {
+        events.emplace_back(event.kind, std::string(event.argument) + "=" + std::string(event.value));
+        if (events.size() == 1) {
+            ASSERT_EQ(number, 5);
+        }
+    }
+
+    const std::vector<std::pair<ParseEventKind, std::string>> expected = {
+        {ParseEventKind::kValue, "--number=5"},
+        {ParseEventKind::kPositional, "--input=10"},
+        {ParseEventKind::kFlag, "--flag1="},
+        {ParseEventKind::kFlag, "--flag2="},
+        {ParseEventKind::kPositional, "--input=20"},
+        {ParseEventKind::kValue, "--number=7"},
+    };
+    ASSERT_EQ(events, expected);
+    ASSERT_EQ(number, 7);
+
+    const auto wrong = SplitString("app -n five");
+    auto generator = parser.Events(wrong);
+    auto it = generator.begin();
+    ASSERT_EQ(it->kind, ParseEventKind::kError);
+    ASSERT_EQ(it->argument, "--number");
+    ASSERT_EQ(it->value, "five");
+    ASSERT_TRUE(++it == generator.end());
+}
+
+TEST(ArgParserTestSuite, MemoryFootprintTest) {
+    ArgParser parser("My Parser");
+    const auto empty = parser.MemoryFootprint();
+
+    for (int i = 0 ; i < 100 ; ++i) {
+        parser.AddIntArgument("--param" + std::to_string(i)).Default(i);
+    }
+    parser.AddFlag("-a", "--flag1", "");
+
+    const auto report = parser.MemoryFootprint();
+    ASSERT_GE(report.strings, std::string("--param0").size() * 100);
+    ASSERT_GT(report.arguments, empty.arguments);
+    ASSERT_GT(report.index, empty.index);
+    ASSERT_EQ(report.Total(), report.strings + report.arguments + report.index + report.values);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --param42=7 -a")));
+    ASSERT_EQ(parser.GetIntValue("--param42"), 7);
+    ASSERT_EQ(parser.GetIntValue("--param99"), 99);
+    ASSERT_TRUE(parser.GetFlag("--flag1"));
+
+    // AddFlag(name, name) and repeated aliases keep one copy of the bytes
+    StringPool pool;
+    const auto first = pool.Add("--verbose");
+    const auto second = pool.Add("--verbose");
+    ASSERT_EQ(first.offset, second.offset);
+    ASSERT_EQ(pool.View(pool.Add("-v")), "-v");
+    ASSERT_EQ(pool.View(first), "--verbose");
+}
+
+TEST(ArgParserTestSuite, ActionTest) {
+    ArgParser parser("My Parser");
+    int verbosity = 0;
+    std::vector<std::string> log;
+    std::vector<int> values;
+    parser.AddFlag("-v", "--verbose", "").Action([&verbosity] { ++verbosity; });
+    parser.AddIntArgument("--N").MultiValue().Positional().StoreValues(values).Action([&](const int value) {
+        log.push_back(std::to_string(value) + "@" + std::to_string(verbosity));
+    });
+    // Captures more than the inline buffer holds
+    parser.AddStringArgument("-i", "--input", "").MultiValue().Action([&log, prefix = std::string("in:")](
+        const std::string_view file) {
+            log.push_back(prefix + std::string(file));
+        });
+    parser.AddEnumArgument<kModes>("--mode").Default(Mode::kFast).Action([&log](const std::string_view mode) {
+        log.emplace_back(mode);
+    });
+
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 -v 2 -i a.txt --mode=safe -vv 3")));
+    ASSERT_EQ(verbosity, 3);
+    ASSERT_EQ(values, std::vector<int>({1, 2, 3}));
+    ASSERT_EQ(log, std::vector<std::string>({"1@0", "2@1", "in:a.txt", "safe", "3@3"}));
+}
+
+TEST(ArgParserTestSuite, ParseBatchTest) {
+    ArgParser parser("My Parser");
+    int number = -1;
+    std::vector<int> values;
+    parser.AddIntArgument("-n", "--number", "").Range(0, 100).StoreValue(number);
+    parser.AddIntArgument("--N").MultiValue(1).Positional().StoreValues(values);
+    parser.AddFlag("-v", "--verbose", "").Default(false);
+    parser.Parallel(4);
+
+    std::vector<std::string> lines;
+    for (int i = 0 ; i < 1000 ; ++i) {
+        lines.push_back(i % 10 == 0
+                            ? "app -n " + std::to_string(i) + " 1"
+                            : "app  1 " + std::to_string(i) + "\t-v --number=" + std::to_string(i % 100));
+    }
+
+    const auto result = parser.ParseBatch(lines);
+    ASSERT_EQ(result.lines.size(), lines.size());
+    for (size_t i = 0 ; i < lines.size() ; ++i) {
+        const auto events = result.Events(i);
+        if (i % 10 == 0) {
+            ASSERT_EQ(result.lines[i].ok, i <= 100);
+            ASSERT_EQ(events.front().argument, "--number");
+            ASSERT_EQ(events.front().value, std::to_string(i));
+            ASSERT_EQ(events.front().kind, i <= 100 ? ParseEventKind::kValue : ParseEventKind::kError);
+        } else {
+            ASSERT_TRUE(result.lines[i].ok);
+            ASSERT_EQ(events.size(), 4);
+            ASSERT_EQ(events[1].value, std::to_string(i));
+            ASSERT_EQ(events[1].value.data(), lines[i].data() + 7);
+            ASSERT_EQ(events[2].kind, ParseEventKind::kFlag);
+            ASSERT_EQ(events[3].value, std::to_string(i % 100));
+        }
+    }
+    ASSERT_EQ(number, -1);
+    ASSERT_TRUE(values.empty());
+
+    ASSERT_FALSE(parser.ParseBatch(SplitString("app")).lines.front().ok);
+
+    ArgParser quoted("My Parser");
+    quoted.AddStringArgument("--title");
+    const auto quoted_result = quoted.ParseBatch(std::vector<std::string>({
+        "app --title 'hello world'", "app --title \"a b\" --help", "app --title 'open"
+    }));
+    ASSERT_TRUE(quoted_result.lines[0].ok);
+    ASSERT_EQ(quoted_result.Events(0).front().value, "hello world");
+    ASSERT_EQ(quoted_result.Events(1).front().kind, ParseEventKind::kHelp);
+    ASSERT_FALSE(quoted_result.lines[2].ok);
+}
+
+TEST(ArgParserTestSuite, ShellLexerTest) {
+    ShellLexer lexer;
+    std::vector<std::string_view> tokens;
+    const std::string command = "app  plain-token-longer-than-sixteen 'single \\ \"quoted\"' \"double \\\" \\$ \\a\""
+                                "\tmix'ed'\\ word \"\" back\\\nslash";
+    ASSERT_TRUE(lexer.Split(command, tokens));
+    ASSERT_EQ(tokens, std::vector<std::string_view>({
+                  "app", "plain-token-longer-than-sixteen", "single \\ \"quoted\"", "double \" $ \\a",
+                  "mixed word", "", "backslash"
+                  }));
+    ASSERT_EQ(tokens[1].data(), command.data() + 5);
+
+    ASSERT_FALSE(lexer.Split("app 'open", tokens));
+    ASSERT_FALSE(lexer.Split("app \"open\\\"", tokens));
+}
+
+TEST(ArgParserTestSuite, ParseCommandStringTest) {
+    ArgParser parser("My Parser");
+    std::string title;
+    std::vector<int> values;
+    parser.AddStringArgument("-t", "--title", "").StoreValue(title);
+    parser.AddIntArgument("--N").MultiValue().Positional().StoreValues(values);
+
+    ASSERT_TRUE(parser.ParseCommandLine("app 1 --title='hello world' 2 \"3\""));
+    ASSERT_EQ(title, "hello world");
+    ASSERT_EQ(values, std::vector<int>({1, 2, 3}));
+
+    ASSERT_FALSE(parser.ParseCommandLine("app -t 'unterminated"));
+
+    ArgParser braced("My Parser");
+    braced.AddFlag("--x", "");
+    ASSERT_TRUE(braced.Parse({"app", "--x"}));
+}
+
+TEST(ArgParserTestSuite, ConstraintsTest) {
+    ArgParser parser("My Parser");
+    parser.AddFlag("--json").Default(false);
+    parser.AddFlag("--yaml").Default(false);
+    parser.AddStringArgument("--output").Default("-");
+    parser.AddStringArgument("--compress").Default("none").Requires("--output");
+    parser.MutuallyExclusive({"--json", "--yaml"});
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --json --output=a.json")));
+    ASSERT_TRUE(parser.Parse(SplitString("app --yaml --output=a.yaml --compress=gz")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --json --yaml")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --compress=gz")));
+
+    parser.AddIntArgument("--output");
+    ASSERT_FALSE(parser.Parse(SplitString("app --output=a.json")));
+}
+
+TEST(ArgParserTestSuite, RequiredBitsTest) {
+    ArgParser parser("My Parser");
+    for (int i = 0 ; i < 130 ; ++i) {
+        parser.AddIntArgument("--param" + std::to_string(i));
+        if (i != 128)
+            parser.Default(i);
+    }
+
+    ASSERT_FALSE(parser.Parse(SplitString("app --param0=1 --param129=2")));
+    ASSERT_TRUE(parser.Parse(SplitString("app --param128=1")));
+    ASSERT_FALSE(parser.Parse(SplitString("app")));
+}
+
+TEST(ArgParserTestSuite, HandleTest) {
+    ArgParser parser("My Parser");
+    ArgHandle<int> number;
+    ArgHandle<std::vector<int>> values;
+    ArgHandle<std::string> name;
+    ArgHandle<bool> verbose;
+    ArgHandle<Mode> mode;
+    ArgHandle<std::string> wrong;
+    parser.AddIntArgument("-n", "--number", "").Default(1).Handle(number);
+    parser.AddIntArgument("--N").MultiValue().Positional().Handle(values);
+    parser.AddStringArgument("--name").Handle(name);
+    parser.AddFlag("-v", "--verbose", "").Handle(verbose).Handle(wrong);
+    parser.AddEnumArgument<kModes>("--mode").Default(Mode::kFast).Handle(mode);
+
+    ArgHandle<int> scalar;
+    ArgHandle<std::vector<std::string>> list;
+    parser.AddIntArgument("--many").MultiValue().Default(0).Handle(scalar);
+    parser.AddStringArgument("--one").Default("").Handle(list);
+
+    ASSERT_TRUE(number && values && name && verbose && mode);
+    ASSERT_FALSE(wrong);
+    ASSERT_FALSE(scalar);
+    ASSERT_FALSE(list);
+    ASSERT_DEATH(parser.Get(scalar), "empty handle");
+    ASSERT_EQ(parser.Get(number), 1);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 2 --name=x -v -n 5 --mode safe 3")));
+    ASSERT_EQ(parser.Get(number), 5);
+    ASSERT_EQ(parser.Get(values), std::vector<int>({1, 2, 3}));
+    ASSERT_EQ(parser.Get(name), "x");
+    ASSERT_TRUE(parser.Get(verbose));
+    ASSERT_EQ(parser.Get(mode), Mode::kSafe);
+}
+
+TEST(ArgParserTestSuite, StructBindingTest) {
+    struct Options {
+        int threads = 0;
+        std::vector<int> values;
+        std::string name;
+        bool verbose = false;
+        Mode mode = Mode::kFast;
+    };
+
+    Options first;
+    ArgParser parser("My Parser");
+    parser.Bind(first);
+    parser.AddIntArgument("-t", "--threads", "").Default(4).Field(&Options::threads);
+    parser.AddIntArgument("--N").MultiValue().Positional().Field(&Options::values);
+    parser.AddStringArgument("--name").Field(&Options::name);
+    parser.AddFlag("-v", "--verbose", "").Field(&Options::verbose);
+    parser.AddEnumArgument<kModes>("--mode").Default(Mode::kSafe).Field(&Options::mode);
+
+    ASSERT_EQ(first.threads, 4);
+    ASSERT_EQ(first.mode, Mode::kSafe);
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 2 --name=a -v -t 2 --mode=fast")));
+    ASSERT_EQ(first.values, std::vector<int>({1, 2}));
+    ASSERT_EQ(first.name, "a");
+    ASSERT_TRUE(first.verbose);
+
+    Options second;
+    parser.Bind(second);
+    ASSERT_EQ(second.threads, 4);
+    ASSERT_EQ(second.mode, Mode::kSafe);
+    ASSERT_TRUE(parser.Parse(SplitString("app 3 --name=b -t 8")));
+    ASSERT_EQ(second.threads, 8);
+    ASSERT_EQ(second.values, std::vector<int>({3}));
+    ASSERT_EQ(second.name, "b");
+    ASSERT_EQ(first.name, "a");
+    ASSERT_EQ(first.threads, 2);
+    ASSERT_EQ(first.mode, Mode::kFast);
+
+    int other = 0;
+    parser.Bind(other);
+    ASSERT_TRUE(parser.Parse(SplitString("app 4 -t 16")));
+    ASSERT_EQ(second.threads, 16);
+    ASSERT_EQ(other, 0);
+}
+
+TEST(ArgParserTestSuite, RingBufferTest) {
+    RingBuffer<int, 4> ring;
+    for (int i = 0 ; i < 6 ; ++i)
+        ring.Push(i);
+
+    ASSERT_EQ(ring.Size(), 4);
+    ASSERT_EQ(ring.Dropped(), 2);
+    ASSERT_EQ(ring[0], 2);
+    ASSERT_EQ(ring[3], 5);
+}
+
+#ifdef ARG_PARSER_ENABLE_TRACE
+TEST(ArgParserTestSuite, TraceTest) {
+    ArgParser parser("My Parser");
+    parser.AddFlag("-a", "--flag1", "");
+    parser.AddIntArgument("-n", "--number", "").Default(0);
+    parser.AddStringArgument("--name").Default("");
+    parser.AddIntArgument("N").MultiValue().Positional();
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --flag1 -an 3 --name=x 5")));
+
+    const TraceBuffer& trace = parser.Trace();
+    ASSERT_EQ(trace.Size(), 5);
+    ASSERT_EQ(trace[0].decision, TraceDecision::kExactMatch);
+    ASSERT_EQ(trace[1].decision, TraceDecision::kBundle);
+    ASSERT_EQ(trace[2].decision, TraceDecision::kBundle);
+    ASSERT_EQ(trace[2].argument, "--number");
+    ASSERT_EQ(trace[3].decision, TraceDecision::kEqualsSplit);
+    ASSERT_EQ(trace[4].decision, TraceDecision::kPositional);
+    ASSERT_EQ(trace[4].token, 5);
+
+    ASSERT_FALSE(parser.Parse(SplitString("app -n 1 -z")));
+    std::ostringstream dump;
+    parser.DumpTrace(dump);
+    ASSERT_EQ(dump.str(), "#1 key alias -> --number\n#3 unknown\n");
+}
+#endif
+
+TEST(ArgParserTestSuite, PassThroughTest) {
+    ArgParser parser("My Parser");
+    parser.AddFlag("-v", "--verbose", "");
+    parser.AddIntArgument("-j", "--jobs", "").Default(1);
+    parser.PassThrough();
+
+    char program[] = "wrapper";
+    char verbose[] = "-v";
+    char unknown[] = "--color";
+    char jobs[] = "-j4";
+    char separator[] = "--";
+    char child_verbose[] = "-v";
+    char file[] = "file.txt";
+    char* argv[] = {program, verbose, unknown, jobs, separator, child_verbose, file};
+
+    ASSERT_TRUE(parser.Parse(7, argv));
+    ASSERT_TRUE(parser.GetFlag("--verbose"));
+    ASSERT_EQ(parser.GetIntValue("--jobs"), 1);
+
+    const std::span<char* const> forwarded = parser.PassThroughArgs();
+    ASSERT_EQ(forwarded.size(), 4);
+    ASSERT_EQ(forwarded[0], unknown);
+    ASSERT_EQ(forwarded[1], jobs);
+    ASSERT_EQ(forwarded[2], child_verbose);
+    ASSERT_EQ(forwarded[3], file);
+    ASSERT_EQ(forwarded.data()[4], nullptr);
+}
+
+TEST(ArgParserTestSuite, Utf8Test) {
+    ASSERT_TRUE(IsValidUtf8(""));
+    ASSERT_TRUE(IsValidUtf8(std::string(100, 'a') + "\xD0\xBF\xD1\x80\xD0\xB8\xE2\x82\xAC\xF0\x9F\x98\x80" + std::string(40, 'b')));
+    ASSERT_FALSE(IsValidUtf8(std::string(20, 'a') + "\xC0\xAF")); // overlong
+    ASSERT_FALSE(IsValidUtf8("\xED\xA0\x80")); // surrogate
+    ASSERT_FALSE(IsValidUtf8("\xF4\x90\x80\x80")); // above U+10FFFF
+    ASSERT_FALSE(IsValidUtf8(std::string(31, 'a') + "\xE2\x82")); // cut at the end
+    ASSERT_TRUE(IsValidUtf8(std::string(14, 'a') + "\xF0\x9F\x98\x80" + std::string(16, 'c'))); // across blocks
+    ASSERT_FALSE(IsValidUtf8(std::string(15, 'a') + "\xE2" + std::string(16, 'c'))); // cut before an ASCII block
+    ASSERT_FALSE(IsValidUtf8(std::string(16, 'a') + "\x80\x80")); // continuations without a lead
+
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("--label").Utf8();
+
+    ASSERT_TRUE(parser.Parse(std::vector<std::string>{"app", "--label=\xD0\xBC\xD0\xB8\xD1\x80"}));
+    ASSERT_FALSE(parser.Parse(std::vector<std::string>{"app", "--label=\xFF"}));
+}
+
+TEST(ArgParserTestSuite, SharedResultsTest) {
+    ArgParser parser("My Parser");
+    parser.AddFlag("-v", "--verbose", "");
+    parser.AddIntArgument("-t", "--threads", "").Default(1);
+    parser.AddStringArgument("--name").Default("none");
+    parser.AddIntArgument("N").MultiValue().Positional();
+    parser.AddEnumArgument<kModes>("--mode").Default(Mode::kSafe);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -v --name=worker 1 2 3 --mode fast")));
+    const int fd = parser.ExportResults();
+    ASSERT_NE(fd, -1);
+
+    SharedResults results;
+    ASSERT_TRUE(results.Attach(fd));
+    close(fd);
+
+    ASSERT_TRUE(results.GetFlag("-v"));
+    ASSERT_TRUE(results.GetFlag("--verbose"));
+    ASSERT_EQ(results.GetIntValue("--threads"), 1);
+    ASSERT_EQ(results.GetStringValue("--name"), "worker");
+    ASSERT_EQ(results.GetStringValue("--mode"), "fast");
+    ASSERT_EQ(results.Count("N"), 3);
+    ASSERT_EQ(results.GetIntValue("N", 2), 3);
+    ASSERT_FALSE(results.Contains("--other"));
+    ASSERT_EQ(results.GetIntValue("--name"), 0);
+}
+
+TEST(ArgParserTestSuite, SharedResultsEmptyTest) {
+    ArgParser parser("My Parser");
+    ASSERT_TRUE(parser.Parse(SplitString("app")));
+    const int fd = parser.ExportResults();
+    ASSERT_NE(fd, -1);
+
+    SharedResults results;
+    ASSERT_TRUE(results.Attach(fd));
+    close(fd);
+    ASSERT_FALSE(results.Contains("--verbose"));
+}
+
+TEST(ArgParserTestSuite, SharedResultsMapTest) {
+    ArgParser parser("My Parser");
+    parser.AddMapArgument("-D", "--define", "");
+    parser.AddRangeArgument("--shards", "");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -D CC=gcc -D AR=ar --shards 7,1-3")));
+    const int fd = parser.ExportResults();
+    ASSERT_NE(fd, -1);
+
+    SharedResults results;
+    ASSERT_TRUE(results.Attach(fd));
+    close(fd);
+    ASSERT_EQ(results.Count("--define"), 2);
+    ASSERT_EQ(results.GetStringValue("-D", 0), "AR=ar");
+    ASSERT_EQ(results.GetStringValue("-D", 1), "CC=gcc");
+    ASSERT_EQ(results.Count("--shards"), 2);
+    ASSERT_EQ(results.GetStringValue("--shards", 0), "1-3");
+    ASSERT_EQ(results.GetStringValue("--shards", 1), "7");
+}
+
+TEST(ArgParserTestSuite, MapArgumentTest) {
+    ArgParser parser("My Parser");
+    parser.AddMapArgument("-D", "--define", "");
+    parser.AddMapArgument("--label").UniqueKeys();
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -D CC=gcc --define=CFLAGS=-O2 -D CC=clang --label=a=1 --label b=")));
+    const StringMap& defines = parser.GetMap("-D");
+    ASSERT_EQ(defines.Size(), 2);
+    ASSERT_EQ(defines.Get("CC"), "clang");
+    ASSERT_EQ(defines.Get("CFLAGS"), "-O2");
+    ASSERT_FALSE(defines.Contains("LD"));
+    ASSERT_TRUE(parser.GetMap("--label").Contains("b"));
+
+    ASSERT_FALSE(parser.Parse(SplitString("app --label c=1 --label c=2")));
+    ASSERT_FALSE(parser.Parse(SplitString("app -D novalue")));
+
+    // Last wins replaces reuse the buffer instead of growing it
+    StringMap map;
+    map.Insert("key", "value", true);
+    map.Insert("other", "x", true);
+    const size_t footprint = map.MemoryFootprint();
+    for (int i = 0 ; i < 10000 ; ++i)
+        map.Insert("key", i % 2 == 0 ? "short" : "a longer value", true);
+    ASSERT_EQ(map.Get("key"), "a longer value");
+    ASSERT_EQ(map.Get("other"), "x");
+    ASSERT_LE(map.MemoryFootprint(), footprint + 64);
+}
+
+TEST(ArgParserTestSuite, PathArgumentTest) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "arg_parser_path_test";
+    std::filesystem::create_directories(dir);
+    const std::string file = (dir / "input.txt").string();
+    std::ofstream(file) << "data";
+
+    ArgParser parser("My Parser");
+    parser.AddPathArgument("-o", "--output", "").IsDirectory();
+    parser.AddPathArgument("input").MultiValue().Positional().Readable();
+
+    ASSERT_TRUE(parser.Parse({"app", "-o", dir.string(), file, file}));
+    ASSERT_EQ(parser.PathChecks().size(), 3);
+
+    const std::string missing = (dir / "missing.txt").string();
+    ASSERT_FALSE(parser.Parse({"app", "--output", file, file, missing}));
+    const auto& checks = parser.PathChecks();
+    ASSERT_EQ(checks[0].error, PathError::kNotDirectory);
+    ASSERT_EQ(checks[1].error, PathError::kNone);
+    ASSERT_EQ(checks[2].error, PathError::kMissing);
+    ASSERT_EQ(checks[2].argument, "input");
+
+    ASSERT_FALSE(parser.Parse({"app", missing, "-o"}));
+    ASSERT_EQ(parser.PathChecks().size(), 1);
+    ASSERT_EQ(parser.PathChecks()[0].error, PathError::kMissing);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ArgParserTestSuite, GlobTest) {
+    ASSERT_TRUE(MatchGlob("*.txt", "a.txt"));
+    ASSERT_TRUE(MatchGlob("f?le[0-9]", "file7"));
+    ASSERT_FALSE(MatchGlob("[!a]*", "abc"));
+    ASSERT_FALSE(MatchGlob("*", ".hidden"));
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "arg_parser_glob_test";
+    std::filesystem::create_directories(dir / "a" / "b");
+    std::filesystem::create_directories(dir / "c");
+    for (const auto* file: {"x.csv", "a/y.csv", "a/b/z.csv", "c/w.txt"})
+        std::ofstream(dir / file) << "data";
+
+    ArgParser parser("My Parser");
+    std::vector<std::string> files;
+    parser.AddStringArgument("files").MultiValue().Positional().Glob().StoreValues(files);
+
+    const std::string root = dir.string();
+    ASSERT_TRUE(parser.Parse({"app", root + "/**/*.csv", root + "/c/*.txt", root + "/none/*.csv"}));
+    ASSERT_EQ(files, std::vector<std::string>({root + "/a/b/z.csv", root + "/a/y.csv", root + "/x.csv",
+                                               root + "/c/w.txt", root + "/none/*.csv"}));
+
+    ArgParser single("My Parser");
+    single.AddStringArgument("--file").Glob();
+    ASSERT_TRUE(single.Parse({"app", "--file", root + "/*.csv"}));
+    ASSERT_EQ(single.GetStringValue("--file"), root + "/*.csv");
+
+    // A trailing ** matches files too, the walk stops at the values the argument has left
+    std::vector<std::string> found;
+    ArgParser limited("My Parser");
+    limited.AddStringArgument("files").MultiValue(1, 3).Positional().Glob().StoreValues(found);
+    ASSERT_TRUE(limited.Parse({"app", root + "/a/**"}));
+    ASSERT_EQ(found, std::vector<std::string>({root + "/a/b", root + "/a/b/z.csv", root + "/a/y.csv"}));
+    ASSERT_FALSE(limited.Parse({"app", root + "/**"}));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ArgParserTestSuite, RangeSetTest) {
+    ArgParser parser("My Parser");
+    parser.AddRangeArgument("-s", "--shards", "");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -s 300-400,1-100,200 --shards=0-9999999")));
+    const IntRangeSet& shards = parser.GetRangeSet("--shards");
+    ASSERT_EQ(shards.Intervals().size(), 1);
+    ASSERT_EQ(shards.Size(), 10000000);
+
+    IntRangeSet set;
+    ASSERT_TRUE(set.Add("-5--3,10,1-2,3,11-12"));
+    ASSERT_EQ(set.Intervals().size(), 3);
+    ASSERT_EQ(set.Size(), 9);
+    ASSERT_TRUE(set.Contains(-4));
+    ASSERT_TRUE(set.Contains(3));
+    ASSERT_FALSE(set.Contains(5));
+    ASSERT_EQ(std::vector<int>(set.begin(), set.end()), std::vector<int>({-5, -4, -3, 1, 2, 3, 10, 11, 12}));
+    ASSERT_FALSE(set.Add("7-5"));
+    ASSERT_EQ(set.Size(), 9);
+
+    IntRangeSet descending;
+    for (int i = 1000 ; i > 0 ; i -= 2)
+        descending.Add(i, i);
+    ASSERT_EQ(descending.Size(), 500);
+    ASSERT_TRUE(descending.Add("1-1000,4-7"));
+    ASSERT_EQ(descending.Intervals().size(), 1);
+    ASSERT_EQ(descending.Size(), 1000);
+
+    ASSERT_FALSE(parser.Parse(SplitString("app -s 1-2,x")));
+}
+
+TEST(ArgParserTestSuite, ParallelRangeSetTest) {
+    ArgParser parser("My Parser");
+    parser.AddRangeArgument("--shards", "").MultiValue().Positional();
+    parser.Parallel(2);
+
+    std::vector<std::string> args = {"app"};
+    for (int i = 0 ; i < 10000 ; ++i)
+        args.push_back(std::to_string(i * 2));
+
+    ASSERT_TRUE(parser.Parse(args));
+    ASSERT_EQ(parser.GetRangeSet("--shards").Size(), 10000);
+    ASSERT_TRUE(parser.GetRangeSet("--shards").Contains(19998));
+}
+
+TEST(ArgParserTestSuite, LazyDefaultTest) {
+    int probes = 0;
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("-t", "--threads", "").Default([&probes] {
+        ++probes;
+        return 8;
+    });
+    parser.AddStringArgument("--config").Default([] { return std::string("/etc/app.conf"); });
+    parser.AddEnumArgument<kModes>("--mode").Default([] { return Mode::kDebug; });
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --threads 2 --config=local.conf --mode safe")));
+    ASSERT_EQ(probes, 0);
+    ASSERT_EQ(parser.GetIntValue("--threads"), 2);
+
+    ArgParser fresh("My Parser");
+    fresh.AddIntArgument("-t", "--threads", "").Default([&probes] {
+        ++probes;
+        return 8;
+    });
+    fresh.AddEnumArgument<kModes>("--mode").Default([] { return Mode::kDebug; });
+    ASSERT_TRUE(fresh.Parse(SplitString("app")));
+    ASSERT_TRUE(fresh.Parse(SplitString("app")));
+    ASSERT_EQ(probes, 1);
+    ASSERT_EQ(fresh.GetIntValue("-t"), 8);
+    ASSERT_EQ(fresh.GetEnumValue<Mode>("--mode"), Mode::kDebug);
+
+    ArgParser multi("My Parser");
+    multi.AddIntArgument("--N").MultiValue(2).Default([] { return 7; });
+    ASSERT_TRUE(multi.Parse(SplitString("app")));
+}
+
+TEST(ArgParserTestSuite, EnvTest) {
+    setenv("APP_TEST_THREADS", "6", 1);
+    setenv("APP_TEST_VERBOSE", "yes", 1);
+    setenv("APP_TEST_NAME", "from-env", 1);
+
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("--threads").Env("APP_TEST_THREADS").Default(1);
+    parser.AddFlag("--verbose").Env("APP_TEST_VERBOSE");
+    parser.AddStringArgument("--name").Env("APP_TEST_NAME");
+    parser.AddIntArgument("--level").Env("APP_TEST_LEVEL").Default(3);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --name cli")));
+    ASSERT_EQ(parser.GetIntValue("--threads"), 6);
+    ASSERT_TRUE(parser.GetFlag("--verbose"));
+    ASSERT_EQ(parser.GetStringValue("--name"), "cli");
+    ASSERT_EQ(parser.GetIntValue("--level"), 3);
+
+    setenv("APP_TEST_THREADS", "six", 1);
+    ArgParser invalid("My Parser");
+    invalid.AddIntArgument("--threads").Env("APP_TEST_THREADS");
+    ASSERT_FALSE(invalid.Parse(SplitString("app")));
+
+    unsetenv("APP_TEST_THREADS");
+    ArgParser required("My Parser");
+    required.AddIntArgument("--threads").Env("APP_TEST_THREADS");
+    ASSERT_FALSE(required.Parse(SplitString("app")));
+
+    unsetenv("APP_TEST_VERBOSE");
+    unsetenv("APP_TEST_NAME");
+}
+
+TEST(ArgParserTestSuite, PushParserTest) {
+    std::vector<std::string> files;
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("-t", "--threads", "");
+    parser.AddFlag("-v", "--verbose", "");
+    parser.AddStringArgument("--file").MultiValue().Positional().StoreValues(files);
+
+    PushParser push(parser);
+    ASSERT_TRUE(push.Feed("--threads").empty());
+    ASSERT_TRUE(push.IsPending());
+    auto events = push.Feed("4");
+    ASSERT_EQ(events.size(), 1);
+    ASSERT_EQ(events[0].kind, ParseEventKind::kValue);
+    ASSERT_EQ(events[0].value, "4");
+    ASSERT_EQ(events[0].position, 1);
+    ASSERT_EQ(push.Feed("-v")[0].kind, ParseEventKind::kFlag);
+    ASSERT_EQ(push.Feed("a.txt")[0].kind, ParseEventKind::kPositional);
+    ASSERT_EQ(push.Feed("b.txt")[0].position, 5);
+    ASSERT_TRUE(push.Finish().empty());
+    ASSERT_FALSE(push.IsFailed());
+    ASSERT_EQ(parser.GetIntValue("-t"), 4);
+    ASSERT_TRUE(parser.GetFlag("--verbose"));
+    ASSERT_EQ(files, std::vector<std::string>({"a.txt", "b.txt"}));
+
+    PushParser invalid(parser);
+    invalid.Feed("--threads");
+    events = invalid.Feed("four");
+    ASSERT_EQ(events.back().kind, ParseEventKind::kError);
+    ASSERT_EQ(events.back().value, "four");
+    ASSERT_TRUE(invalid.IsFailed());
+    ASSERT_TRUE(invalid.Feed("a.txt").empty());
+
+    PushParser missing(parser);
+    missing.Feed("a.txt");
+    ASSERT_EQ(missing.Finish().back().kind, ParseEventKind::kError);
+}
+
 TEST(ArgParserTestSuite, HelpTest) {
     ArgParser parser("My Parser");
     parser.AddHelp("Some Description about program");
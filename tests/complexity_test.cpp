@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#include "arg_parser.h"
+
+using namespace ArgumentParser;
+
+// Every allocation made while the test binary runs is counted, Parse has to stay linear in both
+namespace {
+size_t allocations = 0;
+size_t allocated_bytes = 0;
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    allocated_bytes += size;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+constexpr size_t kBaseSize = 1 << 14;
+constexpr size_t kScale = 8;
+constexpr int kRuns = 3;
+
+struct ParseCost {
+    size_t allocations = 0;
+    size_t bytes = 0;
+    double seconds = 0;
+};
+
+// Builds a schema in the parser and returns the crafted command line of the given size
+using CaseBuilder = std::function<std::vector<std::string>(ArgParser&, size_t)>;
+
+ParseCost Measure(const CaseBuilder& build, const size_t size) {
+    ParseCost cost{0, 0, 1e9};
+
+    for (int run = 0 ; run < kRuns ; ++run) {
+        ArgParser parser("Complexity");
+        const auto args = build(parser, size);
+
+        allocations = 0;
+        allocated_bytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        const bool is_parsed = parser.Parse(args);
+        const auto stop = std::chrono::steady_clock::now();
+
+        EXPECT_TRUE(is_parsed);
+        cost.allocations = allocations;
+        cost.bytes = allocated_bytes;
+        cost.seconds = std::min(cost.seconds, std::chrono::duration<double>(stop - start).count());
+    }
+
+    return cost;
+}
+
+// A quadratic path grows kScale times faster than these bounds allow
+void ExpectLinear(const CaseBuilder& build) {
+    const auto small = Measure(build, kBaseSize);
+    const auto large = Measure(build, kBaseSize * kScale);
+
+    EXPECT_LE(large.allocations, 2 * kScale * small.allocations + 64);
+    EXPECT_LE(large.bytes, 2 * kScale * small.bytes + 4096);
+    EXPECT_LE(large.seconds, 4 * kScale * small.seconds + 0.005);
+}
+}
+
+TEST(ArgParserComplexityTestSuite, HugeBundleTest) {
+    ExpectLinear([](ArgParser& parser, const size_t size) {
+        parser.AddFlag("-a", "--flag1", "");
+        parser.AddFlag("-b", "--flag2", "");
+        parser.AddStringArgument("-c", "--param", "");
+
+        std::string bundle = "-";
+        for (size_t i = 0 ; i < size ; ++i)
+            bundle += i % 2 == 0 ? 'a' : 'b';
+        bundle += 'c';
+
+        return std::vector<std::string>{"app", bundle, "value"};
+    });
+}
+
+TEST(ArgParserComplexityTestSuite, ManyEqualsTest) {
+    ExpectLinear([](ArgParser& parser, const size_t size) {
+        parser.AddStringArgument("--param1").MultiValue();
+
+        std::vector<std::string> args = {"app", "--param1=" + std::string(size, '=')};
+        for (size_t i = 0 ; i < size / 16 ; ++i)
+            args.push_back("--param1=" + std::string(16, '='));
+
+        return args;
+    });
+}
+
+TEST(ArgParserComplexityTestSuite, EmptyTokensTest) {
+    ExpectLinear([](ArgParser& parser, const size_t size) {
+        parser.AddStringArgument("--input").MultiValue().Positional();
+
+        std::vector<std::string> args(size + 1);
+        args[0] = "app";
+
+        return args;
+    });
+}
+
+TEST(ArgParserComplexityTestSuite, LongNamesTest) {
+    ExpectLinear([](ArgParser& parser, const size_t size) {
+        const std::string name = "--" + std::string(size, 'x');
+        parser.AddStringArgument(name);
+        parser.AddStringArgument("--input").MultiValue().Positional();
+
+        return std::vector<std::string>{"app", name + "=value", name.substr(0, size) + "y", name + "y=value"};
+    });
+}
+
+TEST(ArgParserComplexityTestSuite, LongPositionalListTest) {
+    ExpectLinear([](ArgParser& parser, const size_t size) {
+        parser.AddIntArgument("--N").MultiValue().Positional();
+        parser.AddFlag("-s", "--sum", "");
+
+        std::vector<std::string> args = {"app"};
+        for (size_t i = 0 ; i < size ; ++i)
+            args.push_back(i % 1024 == 0 ? "-s" : std::to_string(i));
+
+        return args;
+    });
+}